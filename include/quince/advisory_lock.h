@@ -0,0 +1,93 @@
+#ifndef QUINCE__advisory_lock_h
+#define QUINCE__advisory_lock_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <boost/noncopyable.hpp>
+#include <quince/detail/session.h>
+
+
+namespace quince {
+
+class database;
+
+// How long an advisory_lock is held, if it isn't released sooner.
+//
+enum class advisory_lock_scope {
+    session,        // until the advisory_lock is destroyed or unlock() is called
+    transaction     // until the end of the current transaction, which must exist
+};
+
+// An advisory lock is a lock on an application-defined key (any int64_t), which the DBMS
+// keeps on behalf of a session.  It doesn't lock any rows; its only effect is that two
+// sessions can't hold the lock on the same key at the same time.  So it can be used for
+// leader election, or to serialize work on one entity, without a lock table.
+//
+// An advisory_lock acquires the lock in its constructor, on the session that the calling
+// thread is using for db (which is the session of the current transaction, if any), and
+// keeps the thread on that session for as long as the advisory_lock exists.  Like
+// std::unique_lock, there are constructors that wait indefinitely, that don't wait at all,
+// and that wait up to a given time, e.g.:
+//
+//      const advisory_lock leader(db, election_key, std::try_to_lock);
+//      if (leader)  lead();
+//
+// Backends that support advisory locks override sql::write_advisory_lock() etc.; the
+// others throw unsupported_exception.
+//
+class advisory_lock : private boost::noncopyable {
+public:
+    advisory_lock(
+        const database &,
+        int64_t key,
+        advisory_lock_scope = advisory_lock_scope::session
+    );
+
+    advisory_lock(
+        const database &,
+        int64_t key,
+        std::try_to_lock_t,
+        advisory_lock_scope = advisory_lock_scope::session
+    );
+
+    // Tries to acquire the lock repeatedly, backing off between attempts, until it
+    // succeeds or timeout has passed.
+    //
+    advisory_lock(
+        const database &,
+        int64_t key,
+        std::chrono::milliseconds timeout,
+        advisory_lock_scope = advisory_lock_scope::session
+    );
+
+    ~advisory_lock();
+
+    bool owns_lock() const                  { return _owns_lock; }
+    explicit operator bool() const          { return _owns_lock; }
+
+    // Release a session-scope lock now, rather than when the advisory_lock is destroyed.
+    // (A transaction-scope lock can only be released by the end of its transaction, so
+    // this throws unsupported_exception.)
+    //
+    void unlock();
+
+private:
+    void acquire();
+    bool try_acquire();
+
+    const database &_database;
+    const int64_t _key;
+    const advisory_lock_scope _scope;
+    const session _session;  // As long as we hold this, _database will keep using the same session
+    bool _owns_lock;
+};
+
+}
+
+#endif
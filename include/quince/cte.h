@@ -0,0 +1,219 @@
+#ifndef QUINCE__cte_h
+#define QUINCE__cte_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <quince/detail/compiler_specific.h>
+#include <quince/detail/mapper_factory.h>
+#include <quince/detail/table_interface.h>
+#include <quince/detail/util.h>
+#include <quince/query.h>
+
+
+namespace quince {
+
+// Base class of all the cte<T>s.
+//
+class cte_base : protected object_owner, public table_interface {
+
+    // Everything in this class is for quince internal use only.
+
+public:
+    virtual ~cte_base();
+
+    virtual const object_id &query_id() const override          { return _query_id; }
+    virtual const std::string &name() const override            { return _name; }
+    virtual const std::string &basename() const override        { return _name; }
+    virtual const database &get_database() const override       { return _database; }
+
+    virtual void write_table_reference(sql &) const override;
+    virtual column_id_set aliased_columns() const override;
+    virtual void for_each_column(std::function<void(const column_mapper &)>) const override;
+    virtual bool might_have_duplicate_rows() const override;
+
+    // The query that the WITH clause defines this cte as, or nullptr if this is the
+    // reference that a recursive cte's step makes to the cte itself.
+    //
+    const query_base *definition() const                        { return _definition.get(); }
+
+    bool is_recursive() const                                   { return _is_recursive; }
+
+    // The columns of the cte, which are named in the WITH clause.  Their ids are distinct
+    // from those of the definition's columns, so the cte can be used alongside the query
+    // that defines it, or the tables it reads.
+    //
+    const abstract_mapper_base &get_value_mapper_base() const   { return _value_mapper; }
+
+protected:
+    template<typename Value>
+    cte_base(
+        const std::string &name,
+        const std::shared_ptr<const query_base> &definition,
+        bool is_recursive,
+        const std::shared_ptr<const cte_base> &self_reference,
+        const database &database,
+        const Value *
+    ) :
+        _name(name),
+        _definition(definition),
+        _is_recursive(is_recursive),
+        _self_reference(self_reference),
+        _database(database),
+        _value_mapper(own(make_value_mapper<Value>()))
+    {}
+
+private:
+    // The mapper is given a name so that T can be a tuple (whose columns are otherwise
+    // nameless), so the columns of a cte<T> are called e.g. "c.id" or "c<0>".
+    //
+    template<typename T>
+    std::unique_ptr<abstract_mapper_base>
+    make_value_mapper() const {
+        std::unique_ptr<abstract_mapper_base> result = _database.get_mapper_factory().create<T>(std::string("c"));
+        initialize_mapper(*result);
+        return result;
+    }
+
+    object_id _query_id;
+    const std::string _name;
+    const std::shared_ptr<const query_base> _definition;
+    const bool _is_recursive;
+    const std::shared_ptr<const cte_base> _self_reference;  // kept alive for the sake of _definition's columns
+    const database &_database;
+    const abstract_mapper_base &_value_mapper;
+};
+
+
+template<typename> class with_builder;
+template<typename> class with_recursive_builder;
+
+QUINCE_SUPPRESS_MSVC_DOMINANCE_WARNING
+
+// A common table expression: a query that is defined once, in the WITH clause of the
+// statement that uses it, and then referred to by name wherever it is used.  So a query
+// that is used more than once in a statement (e.g. in a join and also in an exists())
+// can be evaluated once, rather than once per use.  You get one by calling with() or
+// with_recursive() (below), then as().
+//
+// Most of the public features of cte are inherited from abstract_query.
+//
+// A statement may use any number of ctes, but each must have a different name.
+//
+template<typename Value>
+class cte : public cte_base, public abstract_query<Value> {
+public:
+    // --- Everything from here to end of class is for quince internal use only. ---
+
+    typedef typename abstract_query<Value>::value_mapper value_mapper;
+
+    virtual const value_mapper &
+    get_value_mapper() const override {
+        return dynamic_cast<const value_mapper &>(get_value_mapper_base());
+    }
+
+    virtual std::unique_ptr<cloneable>
+    clone_impl() const override {
+        return quince::make_unique<cte<Value>>(*this);
+    }
+
+private:
+    friend class with_builder<Value>;
+    friend class with_recursive_builder<Value>;
+
+    cte(
+        const std::string &name,
+        const std::shared_ptr<const query_base> &definition,
+        bool is_recursive,
+        const database &database,
+        const std::shared_ptr<const cte_base> &self_reference = nullptr
+    ) :
+        cte_base(name, definition, is_recursive, self_reference, database, (Value*)nullptr)
+    {}
+};
+
+QUINCE_UNSUPPRESS_MSVC_WARNING
+
+
+template<typename Value>
+class with_builder {
+public:
+    explicit with_builder(const abstract_query<Value> &definition) :
+        _definition(make_definition(definition))
+    {}
+
+    cte<Value>
+    as(const std::string &name) const {
+        return cte<Value>(name, _definition, false, _definition->get_database());
+    }
+
+private:
+    static std::shared_ptr<const query<Value>>
+    make_definition(const abstract_query<Value> &q) {
+        if (const query<Value> * const already = dynamic_cast<const query<Value> *>(&q))
+            return std::make_shared<query<Value>>(*already);
+        else
+            return std::make_shared<query<Value>>(q);
+    }
+
+    const std::shared_ptr<const query<Value>> _definition;
+};
+
+// The cte that with_recursive(anchor, step).as(name) returns is defined as
+//
+//      anchor.union_all(step(self))
+//
+// where self is a reference to the cte itself, so step can extend the result by joining
+// it with more data, e.g. to walk a hierarchy one level at a time:
+//
+//      const cte<employee> chain = with_recursive(
+//          employees.where(employees->id == boss_id),
+//          [&](const cte<employee> &self) {
+//              return self.jump(employees, employees->boss == self->id);
+//          }
+//      ).as("chain");
+//
+template<typename Value>
+class with_recursive_builder {
+public:
+    typedef std::function<query<Value>(const cte<Value> &)> step_type;
+
+    with_recursive_builder(const abstract_query<Value> &anchor, const step_type &step) :
+        _anchor(clone(anchor)),
+        _step(step)
+    {}
+
+    cte<Value>
+    as(const std::string &name) const {
+        const database &db = _anchor->get_database();
+        const std::shared_ptr<const cte<Value>> self(new cte<Value>(name, nullptr, true, db));
+        const auto definition = std::make_shared<query<Value>>(_anchor->union_all(_step(*self)));
+        return cte<Value>(name, definition, true, db, self);
+    }
+
+private:
+    const std::shared_ptr<const abstract_query<Value>> _anchor;
+    const step_type _step;
+};
+
+
+template<typename Value>
+with_builder<Value>
+with(const abstract_query<Value> &definition) {
+    return with_builder<Value>(definition);
+}
+
+template<typename Value, typename Step>
+with_recursive_builder<Value>
+with_recursive(const abstract_query<Value> &anchor, const Step &step) {
+    return with_recursive_builder<Value>(anchor, step);
+}
+
+}
+
+#endif
@@ -23,6 +23,7 @@ namespace quince {
 
 enum class combination_type;
 enum class conditional_junction_type;
+enum class sample_method;
 struct index_spec;
 class serial_mapper;
 class sql;
@@ -62,6 +63,62 @@ public:
     virtual bool supports_index(const index_spec &) const = 0;
     virtual bool imposes_combination_precedence() const = 0;
 
+    // True if the DBMS can compare row values, e.g. "(a, b) < ($1, $2)", and can use an
+    // index on (a, b) to evaluate that.  Then multi-column comparisons are written that way,
+    // rather than as a chain of ORs and ANDs.
+    //
+    virtual bool supports_row_value_comparison() const;
+
+    // The DBMS's own estimate (e.g. from its query planner or table statistics) of the
+    // number of rows that select will produce, without executing it; or boost::none if
+    // there's no such estimate.  query::size_estimate() returns this.
+    //
+    virtual boost::optional<uint64_t> estimate_row_count(const sql &select) const;
+
+    // True if this database's sessions implement exec_with_row_count(), i.e. they can tell
+    // how many rows an INSERT, UPDATE or DELETE affected.  Then e.g. remove_if_exists()
+    // is a single DELETE, rather than a query followed by a DELETE.
+    //
+    virtual bool reports_row_counts() const;
+
+    // True if the DBMS accepts "UPDATE ... SET ... FROM ... WHERE ...".  Otherwise
+    // query::update_from() generates correlated subqueries.
+    //
+    virtual bool supports_update_from() const;
+
+    // True if the DBMS accepts "CROSS JOIN LATERAL" and "LEFT JOIN LATERAL", so that
+    // abstract_query::lateral_join() and left_lateral_join() can be used.
+    //
+    virtual bool supports_lateral_join() const;
+
+    // True if the DBMS accepts "FILTER (WHERE ...)" after an aggregate call.  Otherwise
+    // exprn_mapper::filter() is emulated with CASE.
+    //
+    virtual bool supports_aggregate_filter() const;
+
+    // True if the DBMS accepts ROLLUP, CUBE and GROUPING SETS in GROUP BY, so that
+    // group(...).rollup(), cube() and grouping_sets() can be used.
+    //
+    virtual bool supports_grouping_sets() const;
+
+    // True if the DBMS accepts "FOR UPDATE" and "FOR SHARE", optionally followed by
+    // "NOWAIT" or "SKIP LOCKED", at the end of a SELECT, so that query::for_update() etc.
+    // can be used.
+    //
+    virtual bool supports_row_locking() const;
+
+    // True if the DBMS accepts window functions, such as "COUNT(*) OVER ()".  This doesn't
+    // stop anyone from using over(), but query::page() uses it to decide whether it can
+    // count the total in the same statement as it fetches the page.
+    //
+    virtual bool supports_window_functions() const;
+
+    // True if the DBMS accepts "TABLESAMPLE" with the given method, optionally followed by
+    // "REPEATABLE (seed)", after a table name.  Otherwise table::sample() is emulated by
+    // filtering the table with a random test.
+    //
+    virtual bool supports_table_sample(sample_method) const;
+
     template<typename SingleColumnType>
     void
     from_cell(const cell &src, SingleColumnType &dest) const {
@@ -80,6 +137,17 @@ public:
         return * tmp_row.find_cell(mapper->only_column().name());
     }
 
+    // The cells that src would occupy, in the order of its mapper's columns.
+    //
+    template<typename T>
+    std::vector<cell>
+    to_cells(const T &src) const {
+        row tmp_row(this);
+        const auto mapper = temporary_mapper<T>();
+        mapper->to_row(src, tmp_row);
+        return tmp_row.cells_of(*mapper);
+    }
+
     template<typename T>
     column_type
     only_column_type() const {
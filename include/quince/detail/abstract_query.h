@@ -16,14 +16,21 @@ namespace quince {
 
 template<typename> class abstract_mapper;
 typedef abstract_mapper<bool> abstract_predicate;
-class grouping;
+template<typename> class abstract_query;
+class grouping_clause;
 template<typename> class query;
 template<typename> class query_iterator;
+template<typename> class returned_rows;
+template<typename> struct result_page;
 template<typename> class junction;
 template<typename> class conditional_junction;
 
 enum class conditional_junction_type { inner, left, right, full };
 
+// Only for deducing V, in unevaluated contexts, from a subclass of abstract_query<V>.
+//
+template<typename V> V abstract_query_value(const abstract_query<V> &);
+
 
 // abstract_query is the interface that is implemented by everything that is a query in the
 // broad sense, i.e. a query, table, serial_table, table_alias, junction, or conditional_junction.
@@ -84,6 +91,8 @@ public:
     //
     virtual uint64_t size() const                                       { return wrapped().size(); }
     virtual bool empty() const                                          { return wrapped().empty(); }
+    virtual uint64_t size_up_to(uint32_t n) const                       { return wrapped().size_up_to(n); }
+    virtual boost::optional<uint64_t> size_estimate() const             { return wrapped().size_estimate(); }
     virtual query<Value> limit(uint32_t n) const                        { return wrapped().limit(n); }
     virtual query<Value> skip(uint32_t n) const                         { return wrapped().skip(n); }
     virtual query<Value> fetch_size(uint32_t n) const                   { return wrapped().fetch_size(n); }
@@ -93,22 +102,26 @@ public:
     virtual iterator end() const                                        { return wrapped().end(); }
     virtual boost::optional<Value> get() const                          { return wrapped().get(); }
     virtual query<Value> distinct() const                               { return wrapped().distinct(); }
+    virtual query<Value> for_update() const                             { return wrapped().for_update(); }
+    virtual query<Value> for_share() const                              { return wrapped().for_share(); }
+    virtual query<Value> skip_locked() const                            { return wrapped().skip_locked(); }
+    virtual query<Value> nowait() const                                 { return wrapped().nowait(); }
     virtual query<Value> union_(const query<Value> &rhs) const          { return wrapped().union_(rhs); }
     virtual query<Value> union_all(const query<Value> &rhs) const       { return wrapped().union_all(rhs); }
     virtual query<Value> intersect(const query<Value> &rhs) const       { return wrapped().intersect(rhs); }
     virtual query<Value> intersect_all(const query<Value> &rhs) const   { return wrapped().intersect_all(rhs); }
     virtual query<Value> except(const query<Value> &rhs) const          { return wrapped().except(rhs); }
     virtual query<Value> except_all(const query<Value> &rhs) const      { return wrapped().except_all(rhs); }
-    virtual void remove()                                               { wrapped().remove(); }
+    virtual boost::optional<uint64_t> remove()                          { return wrapped().remove(); }
     virtual void remove_existing()                                      { wrapped().remove_existing(); }
     virtual bool remove_if_exists()                                     { return wrapped().remove_if_exists(); }
     virtual std::string to_string() const                               { return wrapped().to_string(); }
 
-    // distinct_on(), group(), order(), update() and select() would be virtuals, operating just
-    // like the virtuals directly above, except for the fact that templated functions can't be virtual.
-    // So I achieve the same result with code: I check whether *this is a query, and if it is
-    // I delegate immediately to the corresponding method in the query class; otherwise I promote
-    // the non-query to a query and delegate.
+    // distinct_on(), group(), order(), update(), claim(), page_after() and select() would be
+    // virtuals, operating just like the virtuals directly above, except for the fact that templated
+    // functions can't be virtual.  So I achieve the same result with code: I check whether *this
+    // is a query, and if it is I delegate immediately to the corresponding method in the query
+    // class; otherwise I promote the non-query to a query and delegate.
     //
     template<typename... Args>
     query<Value>
@@ -121,7 +134,7 @@ public:
     // Defined in grouping.h to avoid a circular header dependency.
     //
     template<typename... Args>
-    grouping
+    grouping_clause
     group(Args && ...) const;
 
     template<typename... Args>
@@ -132,13 +145,70 @@ public:
         return wrapped().order(std::forward<Args>(args)...);
     }
 
-    // TODO generalize this to delegate to versions of update that return a value
-    template<typename... Args>
-    void
-    update(Args &&... args) {
+    template<typename T, typename Source>
+    boost::optional<uint64_t>
+    update(const abstract_mapper<T> &dest, const Source &src) {
+        if (auto q = dynamic_cast<query<Value> *>(this))
+            return q->update(dest, src);
+        return wrapped().update(dest, src);
+    }
+
+    template<typename T, typename Source, typename Result>
+    Result
+    update(const abstract_mapper<T> &dest, const Source &src, const abstract_mapper<Result> &result_mapper) {
+        if (auto q = dynamic_cast<query<Value> *>(this))
+            return q->update(dest, src, result_mapper);
+        return wrapped().update(dest, src, result_mapper);
+    }
+
+    template<typename V, typename T>
+    boost::optional<uint64_t>
+    update_from(const abstract_query<V> &source, const abstract_predicate &on, const abstract_mapper<T> &dest, const abstract_mapper<T> &src) {
+        if (auto q = dynamic_cast<query<Value> *>(this))
+            return q->update_from(source, on, dest, src);
+        return wrapped().update_from(source, on, dest, src);
+    }
+
+    template<typename T, typename Source, typename Result>
+    returned_rows<Result>
+    update_returning(const abstract_mapper<T> &dest, const Source &src, const abstract_mapper<Result> &result_mapper) {
+        if (auto q = dynamic_cast<query<Value> *>(this))
+            return q->update_returning(dest, src, result_mapper);
+        return wrapped().update_returning(dest, src, result_mapper);
+    }
+
+    template<typename Result>
+    returned_rows<Result>
+    remove_returning(const abstract_mapper<Result> &result_mapper) {
         if (auto q = dynamic_cast<query<Value> *>(this))
-            q->update(std::forward<Args>(args)...);
-        wrapped().update(std::forward<Args>(args)...);
+            return q->remove_returning(result_mapper);
+        return wrapped().remove_returning(result_mapper);
+    }
+
+    // page() isn't virtual, because query<Value>::page() uses a query<std::tuple<Value, int64_t>>,
+    // so a virtual would instantiate query<std::tuple<std::tuple<Value, int64_t>, int64_t>>, and so on.
+    //
+    result_page<Value>
+    page(uint32_t offset, uint32_t n) const {
+        if (auto q = dynamic_cast<const query<Value> *>(this))
+            return q->page(offset, n);
+        return wrapped().page(offset, n);
+    }
+
+    template<typename Key>
+    result_page<Value>
+    page_after(const Key &cursor, uint32_t n) const {
+        if (auto q = dynamic_cast<const query<Value> *>(this))
+            return q->page_after(cursor, n);
+        return wrapped().page_after(cursor, n);
+    }
+
+    template<typename T, typename Source>
+    returned_rows<Value>
+    claim(uint32_t n, const abstract_mapper<T> &dest, const Source &src) const {
+        if (auto q = dynamic_cast<const query<Value> *>(this))
+            return q->claim(n, dest, src);
+        return wrapped().claim(n, dest, src);
     }
 
     template<typename Mapper>
@@ -165,6 +235,22 @@ public:
         return wrapped().select(ms...);
     }
 
+    template<typename V>
+    query<Value>
+    semi_join(const abstract_query<V> &that, const abstract_predicate &pred) const {
+        if (auto q = dynamic_cast<const query<Value> *>(this))
+            return q->semi_join(that, pred);
+        return wrapped().semi_join(that, pred);
+    }
+
+    template<typename V>
+    query<Value>
+    anti_join(const abstract_query<V> &that, const abstract_predicate &pred) const {
+        if (auto q = dynamic_cast<const query<Value> *>(this))
+            return q->anti_join(that, pred);
+        return wrapped().anti_join(that, pred);
+    }
+
     // Functions in the join() family build junctions or conditional_junctions out of abstract_querys,
     // so there is no need of any conversion to query.
     //
@@ -200,7 +286,7 @@ public:
             *this,
             that,
             pred,
-            conditional_junction_type::inner,
+            conditional_junction_type::left,
             (Value *) nullptr,
             (boost::optional<V> *) nullptr
         );
@@ -271,6 +357,59 @@ public:
         return full_join<std::tuple<boost::optional<Value>, boost::optional<V>>>(that, pred);
     }
 
+    // lateral_join(f) joins this query with f(m), where m is this query's value mapper,
+    // so f can return a query that refers to the current row of this query -- typically
+    // with order() and limit(), to get the top n rows per row of this query, e.g.:
+    //
+    //      devices.lateral_join([&](const exposed_mapper_type<device> &d) {
+    //          return events.where(events->device == d.id).order(-events->time).limit(5);
+    //      })
+    //
+    // left_lateral_join() is the same except that rows of this query for which f(m)
+    // produces nothing are kept, with boost::none for the right-hand side.
+    //
+    // Throws unsupported_exception unless database::supports_lateral_join().
+    //
+    template<typename Collector, typename Function>
+    conditional_junction<Collector>
+    lateral_join(const Function &f) const {
+        const auto &that = f(get_value_mapper());
+        return conditional_junction<Collector>::lateral(
+            *this,
+            that,
+            conditional_junction_type::inner,
+            (Value *) nullptr,
+            (decltype(abstract_query_value(that)) *) nullptr
+        );
+    }
+
+    template<typename Collector, typename Function>
+    conditional_junction<Collector>
+    left_lateral_join(const Function &f) const {
+        const auto &that = f(get_value_mapper());
+        return conditional_junction<Collector>::lateral(
+            *this,
+            that,
+            conditional_junction_type::left,
+            (Value *) nullptr,
+            (boost::optional<decltype(abstract_query_value(that))> *) nullptr
+        );
+    }
+
+    template<typename Function>
+    auto
+    lateral_join(const Function &f) const
+    -> conditional_junction<std::tuple<Value, decltype(abstract_query_value(f(get_value_mapper())))>> {
+        return lateral_join<std::tuple<Value, decltype(abstract_query_value(f(get_value_mapper())))>>(f);
+    }
+
+    template<typename Function>
+    auto
+    left_lateral_join(const Function &f) const
+    -> conditional_junction<std::tuple<Value, boost::optional<decltype(abstract_query_value(f(get_value_mapper())))>>> {
+        return left_lateral_join<std::tuple<Value, boost::optional<decltype(abstract_query_value(f(get_value_mapper())))>>>(f);
+    }
+
     template<typename T>
     T
     evaluate(const exprn_mapper<T> &exprn) const {
@@ -78,6 +78,9 @@ public:
 
     size_t size() const;
 
+    bool operator==(const cell &) const;
+    bool operator!=(const cell &that) const     { return ! (*this == that); }
+
 private:
     template<typename CxxType>
     void
@@ -15,30 +15,75 @@ namespace quince {
 template<typename> class query;
 class table_base;
 
-// class grouping is what q.group(...) returns.  You should never have to mention this class by name,
-// just call its select() method straight away: q.group(...).select(...).  See the discussion here:
+// class grouping_clause is what q.group(...) returns.  You should never have to mention this class by
+// name, just call its select() method straight away: q.group(...).select(...).  See the discussion here:
 // http://quince-lib.com/queries/select/with_group.html
 //
-class grouping : private object_owner {
+// Before select() you can call rollup(), cube() or grouping_sets(), so that one query computes
+// its aggregates at several levels of grouping, e.g. subtotals and a grand total as well as the
+// detail rows:
+//
+//      sales.group(sales->region, sales->product).rollup().select(sales->region, sales->product, sum(sales->amount), grouping(sales->region, sales->product))
+//
+// In the rows for a coarser level, the columns that aren't grouped at that level are null, so
+// they are best selected as optionals; grouping() (see functions.h) tells which are which.
+// These all require database::supports_grouping_sets().
+//
+class grouping_clause : private object_owner {
 public:
-    grouping(
+    grouping_clause(
         std::unique_ptr<const query_base> query,
         std::vector<std::unique_ptr<const abstract_mapper_base>> &&group_by
     ) :
-        _query(own(query))
+        _query(own(query)),
+        _type(grouping_type::plain)
     {
         // TODO: refactor so I can use the code currently in abstract_expressionist::own_all().
 
         for (auto &g: group_by) _group_by.push_back(&own(g));
     }
 
+    // GROUP BY ROLLUP (...): group by all of the group(...) args, then all but the last, and
+    // so on, down to none of them.
+    //
+    grouping_clause
+    rollup() const {
+        return with_type(grouping_type::rollup, {});
+    }
+
+    // GROUP BY CUBE (...): group by every subset of the group(...) args.
+    //
+    grouping_clause
+    cube() const {
+        return with_type(grouping_type::cube, {});
+    }
+
+    // GROUP BY GROUPING SETS (...): group by each of sets, where each set is given by the
+    // positions of some group(...) args, counting from 0, e.g.
+    //
+    //      q.group(a, b, c).grouping_sets({ {0, 1}, {2}, {} })
+    //
+    // groups by a and b, then by c, then by nothing.  sets must not be empty.
+    //
+    grouping_clause
+    grouping_sets(const std::vector<std::vector<size_t>> &sets) const {
+        if (sets.empty())  throw grouping_set_exception();
+        for (const auto &set: sets)
+            for (const size_t i: set)
+                if (i >= _group_by.size())  throw grouping_set_exception();
+
+        return with_type(grouping_type::sets, sets);
+    }
+
     template<typename Mapper>
     query<typename Mapper::value_type>
     select(const Mapper &mapper) const {
         return query<typename Mapper::value_type>(
             * _query.selectable_equivalent(),
             mapper,
-            clone_all(_group_by)
+            clone_all(_group_by),
+            _type,
+            _sets
         );
     }
 
@@ -60,8 +105,20 @@ public:
     }
 
 private:
+    grouping_clause
+    with_type(grouping_type type, const std::vector<std::vector<size_t>> &sets) const {
+        if (! _query.get_database().supports_grouping_sets())  throw unsupported_exception();
+
+        grouping_clause result(*this);
+        result._type = type;
+        result._sets = sets;
+        return result;
+    }
+
     const query_base &_query;
     std::vector<const abstract_mapper_base *> _group_by;
+    grouping_type _type;
+    std::vector<std::vector<size_t>> _sets;
 };
 
 
@@ -71,9 +128,9 @@ private:
 */
 
 template<typename... Ts>
-grouping
+grouping_clause
 query_base::group(const abstract_mapper<Ts> &... ms) const {
-    return grouping(
+    return grouping_clause(
         clone(*this),
         make_unique_ptr_vector<const abstract_mapper_base>(clone(ms)...)
     );
@@ -81,7 +138,7 @@ query_base::group(const abstract_mapper<Ts> &... ms) const {
 
 template<typename Value>
 template<typename...Args>
-grouping
+grouping_clause
 abstract_query<Value>::group(Args && ... args) const {
     if (auto q = dynamic_cast<const query<Value> *>(this))
         return q->group(std::forward<Args>(args)...);
@@ -81,11 +81,13 @@ protected:
         std::unique_ptr<abstract_query_base> lhs,
         std::unique_ptr<abstract_query_base> rhs,
         const abstract_predicate &pred,
-        conditional_junction_type type
+        conditional_junction_type type,
+        bool is_lateral = false
     ) :
         junction_base(std::move(lhs), std::move(rhs)),
         _predicate(pred),
-        _type(type)
+        _type(type),
+        _is_lateral(is_lateral)
     {}
 
     template<typename T>
@@ -107,9 +109,20 @@ protected:
         return optional_mapper<T>(m);
     }
 
+    // Throws unsupported_exception unless lhs's database supports lateral joins.
+    //
+    static void check_lateral_support(const abstract_query_base &lhs);
+
 private:
+    // True if this is a left join that cmd can write as lhs() alone, because rhs() is a table
+    // whose key is fully equated, by _predicate, to values that don't come from rhs() (so each
+    // lhs() row matches at most one rhs() row), and cmd doesn't reference any of rhs()'s columns.
+    //
+    bool is_eliminable(const sql &cmd) const;
+
     const predicate _predicate;
     conditional_junction_type _type;
+    bool _is_lateral;  // see abstract_query::lateral_join()
 };
 
 
@@ -163,13 +176,15 @@ public:
         conditional_junction_type type,
         L *,    // dummy to indicate left component of destination type
         R *,    // dummy to indicate right component of destination type
-        bool swap_lr = false
+        bool swap_lr = false,
+        bool is_lateral = false
     ) :
         conditional_junction_base(
             swap_lr ? clone<abstract_query_base>(rhs) : clone<abstract_query_base>(lhs),
             swap_lr ? clone<abstract_query_base>(lhs) : clone<abstract_query_base>(rhs),
             pred,
-            type
+            type,
+            is_lateral
         ),
         _value_mapper{
             from_non_optional(lhs.get_value_mapper(), (L*)nullptr),
@@ -177,6 +192,22 @@ public:
         }
     {}
 
+    // A lateral join of lhs with rhs, where rhs may refer to the columns of lhs.  It has
+    // no join condition (rhs can apply its own), so type is inner or left.
+    //
+    template<typename NonoptionalL, typename NonoptionalR, typename L, typename R>
+    static conditional_junction<Collector>
+    lateral(
+        const abstract_query<NonoptionalL> &lhs,
+        const abstract_query<NonoptionalR> &rhs,
+        conditional_junction_type type,
+        L *,
+        R *
+    ) {
+        check_lateral_support(lhs);
+        return conditional_junction<Collector>(lhs, rhs, predicate(true), type, (L*)nullptr, (R*)nullptr, false, true);
+    }
+
     virtual const value_mapper_type &get_value_mapper() const override  { return _value_mapper; }
 
     virtual std::unique_ptr<cloneable>
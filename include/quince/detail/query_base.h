@@ -6,26 +6,39 @@
 //    (See accompanying file ../../../LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <quince/detail/abstract_query.h>
 #include <quince/detail/object_id.h>
 #include <quince/detail/session.h>
+#include <quince/detail/sql.h>
 #include <quince/detail/table_base.h>
 #include <quince/exprn_mappers/detail/exprn_mapper.h>
 
 
 namespace quince {
 
-class grouping;
+class grouping_clause;
 class query_iterator_base;
 template<typename T> class query;
+template<typename T> class returned_rows;
 
 
 // For quince internal use only:
 //
 enum class combination_type { union_, intersect, except };
 
+// How the rows are grouped by the columns passed to group(...): see grouping_clause.
+//
+enum class grouping_type { plain, rollup, cube, sets };
+
+// The row locks that a query takes: see query::for_update() etc.
+//
+enum class row_lock_type { update, share };
+enum class row_lock_wait { wait, nowait, skip_locked };
+
 
 // query_base is the base class of all the query<T>s.  It provides all of a query's public
 // methods that don't depend on the value type, as well as some methods that are for quince
@@ -62,29 +75,35 @@ public:
     // Defined in grouping.h to avoid a circular header dependency.
     //
     template<typename... T>
-    grouping
+    grouping_clause
     group(const abstract_mapper<T> &... mappers) const;
 
+    // The update() and remove() forms that don't return anything else return the number of
+    // rows affected, if the database reports it (see database::reports_row_counts()).
+
     template<typename T>
-    void
+    boost::optional<uint64_t>
     update(const abstract_mapper<T> &dest, const abstract_mapper<T> &src) {
         const abstract_mapper_base &src_as_amb = src;
-        update_impl(dest, src_as_amb);
+        return update_impl(dest, src_as_amb);
     }
 
     template<typename T>
-    void
+    boost::optional<uint64_t>
     update(const abstract_mapper<T> &dest, const T &src) {
         row src_as_row(& get_database());
         dest.to_row(src, src_as_row);
-        update_impl(dest, src_as_row);
+        return update_impl(dest, src_as_row);
     }
 
     template<typename T, typename Result, typename Source>
     Result
     update(const abstract_mapper<T> &dest, const Source &src, const abstract_mapper<Result> &result_mapper) {
         const table_base &t = table();
-        return t.update_with_one_output(dest, *make_new_mapper_checked<T>(src), predicate_applicable_to(t), result_mapper);
+        const std::unique_ptr<row> output =
+            t.update_with_one_output<abstract_mapper_base>(dest, *make_new_mapper_checked<T>(src), predicate_applicable_to(t), _bindings, result_mapper);
+        if (! output)  throw no_row_exception();
+        return result_mapper.from_row(*output);
     }
 
     template<typename T, typename Result>
@@ -93,7 +112,55 @@ public:
         return update(dest, exprn_mapper<T>(src), result_mapper);
     }
 
-    void remove();
+    // Set dest to src in each row of this query's table that matches some row of source,
+    // according to the join condition on.  src may refer to the columns of source, e.g.
+    //
+    //      cities.update_from(countries, cities->country == countries->id, cities->country_name, countries->name)
+    //
+    // It's done in one statement, and returns the number of rows updated if the database
+    // reports it.  If more than one row of source matches, which one supplies src is unspecified.
+    //
+    template<typename V, typename T>
+    boost::optional<uint64_t>
+    update_from(const abstract_query<V> &source, const abstract_predicate &on, const abstract_mapper<T> &dest, const abstract_mapper<T> &src) {
+        const table_base &t = table();
+        return t.update_with_source(dest, src, source, on, predicate_applicable_to(t), _bindings);
+    }
+
+    // update_returning() is like update(dest, src), and remove_returning() is like remove(),
+    // except that each modified (or removed) row is also put through result_mapper, as in
+    // SQL's "RETURNING" clause.  The statement is executed immediately, and its output is
+    // received fetch_size() rows at a time, as the returned_rows are iterated over.
+    //
+    template<typename T, typename Result, typename Source>
+    returned_rows<Result>
+    update_returning(const abstract_mapper<T> &dest, const Source &src, const abstract_mapper<Result> &result_mapper) {
+        const table_base &t = table();
+        return returned_rows<Result>(
+            result_mapper,
+            get_database(),
+            t.update_with_stream_output<abstract_mapper_base>(dest, *make_new_mapper_checked<T>(src), predicate_applicable_to(t), _bindings, result_mapper, _fetch_size)
+        );
+    }
+
+    template<typename T, typename Result>
+    returned_rows<Result>
+    update_returning(const abstract_mapper<T> &dest, const T &src, const abstract_mapper<Result> &result_mapper) {
+        return update_returning(dest, exprn_mapper<T>(src), result_mapper);
+    }
+
+    template<typename Result>
+    returned_rows<Result>
+    remove_returning(const abstract_mapper<Result> &result_mapper) {
+        const table_base &t = table();
+        return returned_rows<Result>(
+            result_mapper,
+            get_database(),
+            t.remove_with_stream_output(predicate_applicable_to(t), _bindings, result_mapper, _fetch_size)
+        );
+    }
+
+    boost::optional<uint64_t> remove();
     void remove_existing();
     bool remove_if_exists();
     
@@ -116,6 +183,12 @@ public:
     //
     bool is_predicational() const;
 
+    // true iff an enclosing query can use this one's _from and _predicate in place of
+    // this query, writing this query's output columns as expressions: i.e. this query only
+    // filters its _from and (optionally) computes output columns without aggregation.
+    //
+    bool is_mergeable_subquery() const;
+
     // true iff this query has any set-theoretic combinations at the top level
     // (i.e. those buried inside _from, or subqueries, don't count).
     //
@@ -134,19 +207,37 @@ public:
     // required output columns have been chosen by the caller and recorded in the
     // internal state of cmd, using sql::wanted_alias_scope. (See <quince/detail/sql.h>)
     //
-    void write_select(sql &cmd) const;
+    //
+    // If existence_test is true, then the select list is "1", and any DISTINCT and ORDER BY
+    // are left out, because the statement will only be used to see if there are any rows.
+    // Only write_existence_select() should do that.
+    //
+    void write_select(sql &cmd, bool existence_test = false) const;
 
     // Write the SQL select statement for this query assuming there is no enclosing
     // SQL context, so it will produce all the columns needed by its value mapper.
     //
     void write_maximal_select(sql &cmd) const;
 
+    // Write an SQL select statement that produces at least one row iff this query does,
+    // e.g. "SELECT 1 FROM ... WHERE ... LIMIT 1", for use in an EXISTS test.  If that
+    // can't be done without changing the meaning, it's just write_maximal_select().
+    //
+    void write_existence_select(sql &cmd) const;
+
     // Returns the ids of all columns c such that, when write_maximal_select() generates
     // the SQL for this query, it would be advantageous if the SQL context had already
     // defined an SQL column alias for c.
     //
     column_id_set imports() const;
 
+    // Returns the ids of all columns that this query's SQL may refer to, whether it exports
+    // them or not, e.g. in a WHERE clause, and including those of the FROM clause's own
+    // subqueries, or universal if that can't be determined.  A lateral subquery may refer to
+    // the preceding joinee's columns in any of these places.
+    //
+    universalizable_column_id_set all_imports() const;
+
     virtual std::unique_ptr<const query_base> selectable_equivalent() const = 0;
 
 protected:
@@ -170,17 +261,32 @@ protected:
     void set_limit(uint32_t n_rows);
     void set_skip(uint32_t n_rows);
     void set_fetch_size(uint32_t n_rows);
-    void set_group_by(std::vector<std::unique_ptr<const abstract_mapper_base >> &&);
+    void
+    set_group_by(
+        std::vector<std::unique_ptr<const abstract_mapper_base >> &&,
+        grouping_type,
+        const std::vector<std::vector<size_t>> &grouping_sets
+    );
     void add_distinct();
     void add_distinct_on(std::vector<std::unique_ptr<const abstract_mapper_base>> &&);
     void add_fake_combine(combination_type, const query_base &rhs);
     void add_real_combine(combination_type, bool all, const query_base &rhs);
     void set_value_mapper_is_inherited(bool);
+    void add_binding(sql::parameter_id, const cell &);
+    void set_decorrelate();
+    void set_row_lock(row_lock_type);
+    void set_row_lock_wait(row_lock_wait);
+
+    // A predicate that is true for the rows that come after (or, if !after, before) the
+    // row whose order columns hold key, in the ordering given by this query's order().
+    //
+    predicate keyset_predicate(const std::vector<cell> &key, bool after) const;
 
     const boost::optional<std::vector<const abstract_mapper_base *>> &distinct_list() const;
 
     void add_orders(std::vector<std::unique_ptr<const abstract_mapper_base>> &&orders_hi_to_lo);
     void clear_orders();
+    std::vector<const abstract_mapper_base *> all_orders_hi_to_lo() const;
 
     // true iff this query is eligible to be an operand of a fake set-theoretic combination
     // (i.e. a set theoretic combination that is optimized away).
@@ -206,14 +312,57 @@ protected:
     //
     std::unique_ptr<row> fetch_row(const session &) const;
 
+    // Do most of the work of query::empty(), i.e. execute write_existence_select() (which
+    // the caller has arranged to be limited to one row) and see if it produces anything.
+    //
+    bool fetch_any() const;
+
+    // Do most of the work of query::size_estimate(), i.e. ask the database for its own
+    // estimate of the number of rows that this query produces.
+    //
+    boost::optional<uint64_t> fetch_size_estimate() const;
+
 private:
+    friend class query_batch;
+
     template<typename T, typename Src>  // Src is abstract_mapper_base or row
-    void update_impl(const abstract_mapper<T> &dest, const Src &src) {
+    boost::optional<uint64_t> update_impl(const abstract_mapper<T> &dest, const Src &src) {
         const table_base &t = table();
-        t.update_with_no_output(dest, src, predicate_applicable_to(t));
+        return t.update_with_no_output(dest, src, predicate_applicable_to(t), _bindings);
     }
 
     struct combination;
+    struct statement_cache;
+    struct semi_join;
+
+    // If conjunct is exists(q) or in(lhs, q), where q can be evaluated once as a derived
+    // table (see write_select()), then return the semi-join that can replace it.  outer_ids
+    // are the columns of the FROM clause that conjunct is applied to.
+    //
+    static boost::optional<semi_join> find_semi_join(const abstract_predicate &conjunct, const column_id_set &outer_ids);
+
+    // Write " INNER JOIN (SELECT DISTINCT ...) AS q$n ON ...", to follow from's table reference.
+    //
+    static void write_semi_join(sql &, const semi_join &, const abstract_query_base &from);
+
+    // Make an sql object containing write_maximal_select(), with its text buffer reserved
+    // according to the size of the last statement generated for this query (or any query
+    // it was copied from).
+    //
+    // If the statement has params, it is generated only once, and then shared by all copies
+    // of this query (e.g. the ones that bind() returns), until one of them is modified.
+    //
+    std::unique_ptr<sql> make_maximal_select() const;
+
+    // Same as make_maximal_select(), but ready for execution: _bindings are bound to its
+    // params (and we throw unbound_parameter_exception if any param has no value).
+    //
+    std::unique_ptr<sql> make_bound_select() const;
+
+    // Called by every method that changes the SQL this query generates, so that it
+    // stops sharing its statement_cache with the query it was copied from.
+    //
+    void discard_statement_cache();
 
     predicate predicate_applicable_to(const table_base &) const;
 
@@ -221,8 +370,6 @@ private:
 
     const table_base &table() const;
 
-    std::vector<const abstract_mapper_base *> all_orders_hi_to_lo() const;
-
     object_id _query_id;
     object_id::value_type _from_id;
     const abstract_query_base &_from;
@@ -231,11 +378,24 @@ private:
     predicate _predicate;
     boost::optional<std::vector<const abstract_mapper_base *>> _distinct_list;
     std::vector<const abstract_mapper_base *> _group_by;
+    grouping_type _grouping_type;
+    std::vector<std::vector<size_t>> _grouping_sets;  // indexes into _group_by, for grouping_type::sets
     std::vector<const abstract_mapper_base *> _orders_lo_to_hi;
     boost::optional<uint32_t> _limit;
     uint32_t _offset;
     uint32_t _fetch_size;
     std::vector<const combination *> _combinations;
+    bool _decorrelate;
+    boost::optional<row_lock_type> _row_lock;
+    row_lock_wait _row_lock_wait;
+
+    sql::parameter_bindings _bindings;
+
+    // Shared by copies, which usually generate statements of a similar size.
+    //
+    std::shared_ptr<std::atomic<size_t>> _text_size_hint;
+
+    std::shared_ptr<statement_cache> _statement_cache;
 };
 
 
@@ -255,6 +415,7 @@ protected:
 private:
     friend class query_base;
     template<typename Table> friend class iterator;
+    template<typename> friend class returned_rows;
 
     void init(const result_stream &);
     const session &get_session() const;
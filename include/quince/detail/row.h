@@ -84,8 +84,23 @@ public:
     void add_cells(const std::vector<cell> &);
     void add_cells(const row &);
 
+    // Overwrite the index'th cell (counting from 0, in order of addition).
+    //
+    void replace_cell(size_t index, const cell &);
+
+    size_t size() const;
+
+    // True iff that has the same cells as this, in the same order (regardless of names).
+    //
+    bool has_same_cells(const row &that) const;
+
     std::vector<cell> values() const;
 
+    // The cells for the given columns, in the order of the columns.  (Missing cells are
+    // represented by empty cells.)
+    //
+    std::vector<cell> cells_of(const abstract_column_sequence &) const;
+
     boost::optional<row> pick(const std::vector<std::string> &names) const;
 
     const cell &only_cell() const;
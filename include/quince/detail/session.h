@@ -6,6 +6,7 @@
 //    (See accompanying file ../../../LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -45,6 +46,28 @@ public:
     virtual result_stream           exec_with_stream_output(const sql &, uint32_t fetch_size) = 0;
     virtual std::unique_ptr<row>    exec_with_one_output(const sql &) = 0;
     virtual std::unique_ptr<row>    next_output(const result_stream &) = 0;
+
+    // Like exec(), but also return the number of rows that the statement inserted, updated
+    // or deleted.  Backends that can report it should override this and database::reports_row_counts().
+    //
+    virtual boost::optional<uint64_t>
+    exec_with_row_count(const sql &cmd) {
+        exec(cmd);
+        return boost::none;
+    }
+
+    // Execute several independent statements with multi-row output, and pass each row of
+    // output to receive, along with the index in cmds of the statement that produced it.
+    // Backends that can send all the statements in one round trip (by pipelining, or as one
+    // request with multiple result sets) should override this; the default executes them
+    // one after another, so it costs a round trip per statement.
+    //
+    virtual void
+    exec_batch_with_output(
+        const std::vector<const sql *> &cmds,
+        uint32_t fetch_size,
+        const std::function<void(size_t, const row &)> &receive
+    );
 };
 
 typedef std::shared_ptr<abstract_session_impl> session;
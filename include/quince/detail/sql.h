@@ -7,6 +7,8 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <stdint.h>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <boost/optional.hpp>
@@ -26,6 +28,10 @@ namespace quince {
 
 typedef int64_t column_id;
 enum class combination_type;
+enum class grouping_type;
+enum class advisory_lock_scope;
+enum class row_lock_type;
+enum class row_lock_wait;
 enum class relation;
 typedef universalizable_set<column_id> universalizable_column_id_set;
 class abstract_query_base;
@@ -39,6 +45,10 @@ template<typename> class abstract_mapper;
 typedef abstract_mapper<bool> abstract_predicate;
 enum class conditional_junction_type;
 class collective_base;
+struct window_definition;
+class cte_base;
+struct frame_bound;
+struct table_sample;
 
 
 // An sql object represents an SQL command (possibly a work in progress), including the
@@ -63,10 +73,19 @@ class collective_base;
 class sql : public cloneable {
 public:
     typedef std::string::size_type marker_t;
+    typedef uint64_t parameter_id;
+    typedef std::map<parameter_id, cell> parameter_bindings;
 
     virtual ~sql() {}
 
     void write(const std::string &);
+    void write(const char *);
+    void write(char);
+
+    // Make room for at least n characters of SQL text, so that a command whose approximate
+    // size is known in advance can be generated without repeated reallocation.
+    //
+    void reserve(size_t n);
 
     virtual void write_quoted(const std::string &);
     virtual void write_quoted(const binomen &);
@@ -77,12 +96,48 @@ public:
         write_value(get_database().to_cell(value));
     }
 
+    // Write a placeholder for the param identified by id, and attach a cell for it:
+    // either the value that add_parameter_bindings() has already supplied, or an empty
+    // cell to be filled in by bind_parameters() before the command is executed.
+    //
+    // Unlike write_value(), this never lets the backend embed a value in the text
+    // (see next_value_reference()), so the text is the same whatever values are bound.
+    //
+    virtual void write_parameter(parameter_id id);
+
     virtual void write_evaluation(const column_mapper &);
     virtual void write_persistent_column(const std::string &table_name, const std::string &column_name);
     virtual void write_function_call(const std::string &function_name, const std::vector<const column_mapper *> &args);
+
+    // Write a call of an aggregate or window function.  If a filter_scope or window_scope
+    // is awaiting its first such call, then this is it, and it is followed by FILTER and
+    // the predicate, and/or OVER and the window.
+    //
+    // See make_aggregate_call_expressionist() for the meaning of distinct and ordered_by.
+    //
+    virtual void
+    write_aggregate_call(
+        const std::string &function_name,
+        const std::vector<const column_mapper *> &args,
+        bool distinct,
+        const column_mapper *ordered_by
+    );
+
+    // Write the parenthesized window that follows OVER.
+    //
+    virtual void write_window(const window_definition &);
+
     virtual void write_prefix_exprn(const std::string &op, const column_mapper &operand);
     virtual void write_postfix_exprn(const column_mapper &operand, const std::string &op);
     virtual void write_infix_exprn(const column_mapper &lhs, const std::string &op, const column_mapper &rhs);
+
+    // Write the operands (which are predicates) joined by op, which is and_operator or
+    // or_operator.  Operands that would be written identically, with the same values and
+    // params, are written only once,
+    // and, if op is or_operator, equality tests of one column against two or more values
+    // are merged into one write_in_array().
+    //
+    virtual void write_junction(const std::string &op, const std::vector<const abstract_mapper_base *> &operands);
     virtual void write_cast(const column_mapper &arg, const column_type cast_type);
     virtual void write_case(
         boost::optional<const column_mapper &> switch_,
@@ -91,13 +146,37 @@ public:
     );
     virtual void write_scalar_subquery(const query_base &);
     virtual void write_subquery_exists(const query_base &);
+
+    // Write a reference to the common table expression c (see cte.h), and arrange for the
+    // WITH clause of the enclosing statement to define it.
+    //
+    virtual void write_cte_reference(const cte_base &c);
     virtual void write_in(const column_mapper &lhs, const std::vector<const column_mapper *> &rhs);
     virtual void write_in(const column_mapper &lhs, const query_base &rhs);
+
+    // Write a test of whether lhs is equal to any of the given values (which are never
+    // empty).  The default implementation writes one or more IN lists, padding each to
+    // a size from a small fixed set, so that a few statement texts serve all list lengths.
+    // Backends that can bind an array as a single value should override this, to write
+    // something like "lhs = ANY($1)".
+    //
+    virtual void write_in_array(const column_mapper &lhs, const std::vector<cell> &values);
+
     virtual void write_intrinsic_comparison(relation, const abstract_column_sequence &lhs, const abstract_column_sequence &rhs);
     virtual void write_extrinsic_comparison(relation, const abstract_column_sequence &lhs, const row &rhs);
     virtual void write_collective_comparison(relation, const abstract_column_sequence &lhs, const collective_base &rhs);
     virtual void write_are_all_null(const abstract_column_sequence &);
 
+    // Write a predicate that is true for rows that come after (or, if !after, before)
+    // a row whose order columns have the values key, in the ordering given by orders.
+    // Throws keyset_mismatch_exception if key doesn't have one cell per order column.
+    //
+    virtual void write_keyset_comparison(
+        const std::vector<const abstract_mapper_base *> &orders_hi_to_lo,
+        const std::vector<cell> &key,
+        bool after
+    );
+
     virtual void write_nulls_low(bool invert) = 0;
 
     virtual void write_where(const abstract_predicate &);
@@ -109,11 +188,45 @@ public:
     virtual void write_offset(uint32_t);
     virtual void write_select_list_item(const column_mapper &);
     virtual void write_select_list(const abstract_column_sequence &);
-    virtual void write_group_by(const std::vector<const abstract_mapper_base *> &);
+
+    // If type is grouping_type::sets, then each of grouping_sets is a list of indexes into
+    // group_by.
+    //
+    virtual void
+    write_group_by(
+        const std::vector<const abstract_mapper_base *> &group_by,
+        grouping_type type,
+        const std::vector<std::vector<size_t>> &grouping_sets
+    );
+
     virtual void write_ordered_by(const std::vector<const abstract_mapper_base *> &);
+    virtual void write_row_lock(row_lock_type, row_lock_wait);
     virtual void write_values(const abstract_mapper_base &, const row &, boost::optional<column_id> excluded);
     virtual void write_cross_join(const std::vector<const abstract_query_base *> &joinees);   
     virtual void write_qualified_join(const abstract_query_base &lhs, const abstract_query_base &rhs, conditional_junction_type);
+
+    // Write lhs joined with rhs, where rhs may refer to lhs's columns: "lhs CROSS JOIN LATERAL rhs"
+    // if type is inner, or "lhs LEFT JOIN LATERAL rhs ON TRUE" if it's left.
+    //
+    virtual void write_lateral_join(const abstract_query_base &lhs, const abstract_query_base &rhs, conditional_junction_type);
+
+    // What a sampled table writes after its name, if the DBMS supports TABLESAMPLE with the
+    // sample's method: " TABLESAMPLE SYSTEM (percent)" etc.
+    //
+    virtual void write_table_sample(const table_sample &);
+
+    // What a sampled table writes instead of its name otherwise: a subquery that filters the
+    // table with write_random_test(), and is given the table's local name so that column
+    // references are unaffected.  A seed can't be honoured this way, so then it throws
+    // unsupported_exception.
+    //
+    virtual void write_random_sample(const std::string &quoted_table, const std::string &local_name, const table_sample &);
+
+    // Write a boolean expression that is true with probability fraction, independently for
+    // each row, e.g. "random() < fraction".  The DBMS's random function varies, so the
+    // default throws unsupported_exception.
+    //
+    virtual void write_random_test(double fraction);
     virtual void write_combination(combination_type type, bool all, const query_base &rhs);
     virtual void write_on(const abstract_predicate &);
 
@@ -145,6 +258,15 @@ public:
     virtual void write_forget_save_point(const std::string &);
     virtual void write_revert_to_save_point(const std::string &);
 
+    // Statements for advisory_lock.  write_advisory_lock() writes a statement that waits
+    // until it acquires the lock on key, and write_try_advisory_lock() writes one that
+    // doesn't wait, and outputs one bool column: true iff it acquired the lock.  The
+    // defaults throw unsupported_exception.
+    //
+    virtual void write_advisory_lock(int64_t key, advisory_lock_scope);
+    virtual void write_try_advisory_lock(int64_t key, advisory_lock_scope);
+    virtual void write_advisory_unlock(int64_t key);
+
     virtual void write_insert(
         const binomen &table,
         const abstract_mapper_base &,
@@ -165,6 +287,22 @@ public:
         boost::optional<column_id> excluded
     );
 
+    // Write a complete UPDATE statement that sets dest to src in each row of table that
+    // satisfies pred and matches some row of source according to on.  src may refer to
+    // the columns of source.  If the DBMS supports_update_from() then that's written as
+    // "UPDATE ... SET ... FROM <source> WHERE on AND pred", otherwise each column of src
+    // becomes a correlated subquery, and the match is tested with EXISTS.
+    //
+    virtual void write_update_from(
+        const binomen &table,
+        const abstract_mapper_base &dest,
+        const abstract_mapper_base &src,
+        const abstract_query_base &source,
+        const abstract_predicate &on,
+        const abstract_predicate &pred,
+        boost::optional<column_id> excluded
+    );
+
     virtual void write_delete_from(const binomen &table);
     virtual void write_set_search_path(const std::string &schema_name);
 
@@ -184,23 +322,66 @@ public:
     const std::string &get_text() const     { return _text; }
     const bool nested_select() const        { return _nested_select; }
 
+    // Supply values for params that may be written later.  If a param already has a value,
+    // the existing value prevails (so an outer query's bindings override an inner query's).
+    //
+    void add_parameter_bindings(const parameter_bindings &);
+
+    // Fill in the cells attached by write_parameter(), preferring the values in bindings
+    // to those supplied by add_parameter_bindings().  Throws unbound_parameter_exception
+    // if any param still has no value.
+    //
+    void bind_parameters(const parameter_bindings &bindings);
+
+    // Forget the values that add_parameter_bindings() supplied for the params in bindings
+    // (whatever values bindings gives them), so that bind_parameters() won't fall back on
+    // them.  The values supplied by subqueries for other params are kept: they are part of
+    // the statement, whereas the outermost query's bindings are only good for that query.
+    //
+    void forget_parameter_bindings(const parameter_bindings &bindings);
+
+    bool has_parameters() const             { return ! _parameter_slots.empty(); }
+
     bool alias_is_wanted(column_id) const;
     bool alias_is_defined(column_id) const;
 
+    // False if the enclosing SELECT has declared (by means of a referenced_columns_scope)
+    // that nothing it writes, apart from the FROM clause itself, mentions the given column.
+    // See conditional_junction_base::is_eliminable().
+    //
+    bool column_is_referenced(column_id) const;
+
     std::string column_type_name(column_type) const;
 
     static std::string relop(relation);
 
     static const std::string unary_plus_operator;
     static const std::string unary_minus_operator;
+    static const std::string and_operator;
+    static const std::string or_operator;
 
     // Record the current write position, for later use by text_insertion_scope.
     //
     marker_t here() const;
 
+    // If no statement that encloses the current position has claimed the WITH clause,
+    // then begin_with_clause() claims it for a statement that starts here, and returns the
+    // marker to pass to end_with_clause() when that statement is complete.  end_with_clause()
+    // then inserts "WITH ..." at the marker, to define all the ctes that write_cte_reference()
+    // was called for in the meantime (and any that their definitions refer to), if any.
+    //
+    // Ctes are defined before any cte whose definition refers to them.
+    //
+    boost::optional<marker_t> begin_with_clause();
+    void end_with_clause(marker_t);
+
     // Any text added to this sql object during the lifetime of a text_insertion_scope
     // will be inserted, starting at a given marker, rather than appended to the end.
     //
+    // The text is collected in a side buffer while the scope is alive, and spliced into
+    // place (by a single insertion) when the scope ends, so the text that follows the
+    // marker is never copied out and back.
+    //
     // The reason you'd do this, rather than write all the text from left to right,
     // is because you want some text to be exempted from the effects of any wanted_aliases_scope,
     // additional_wanted_alises_scope, aliased_columns_scope or additional_aliased_columns_scope
@@ -219,7 +400,6 @@ public:
         ~text_insertion_scope();
     private:
         sql &_command;
-        const std::string _pending_tail;
     };
 
     class comma_separated_list_scope : private boost::noncopyable {
@@ -249,6 +429,22 @@ public:
         additional_wanted_aliases_scope(sql &, const universalizable_column_id_set &additional_wanted);
     };
 
+    class referenced_columns_scope : private boost::noncopyable {
+    public:
+        referenced_columns_scope(sql &, const universalizable_column_id_set &referenced);
+        ~referenced_columns_scope();
+    protected:
+        explicit referenced_columns_scope(sql &);
+    private:
+        sql &_command;
+        const universalizable_column_id_set _pending;
+    };
+
+    class additional_referenced_columns_scope : private referenced_columns_scope {
+    public:
+        additional_referenced_columns_scope(sql &, const universalizable_column_id_set &additional_referenced);
+    };
+
     class aliased_columns_scope : private boost::noncopyable {
     public:
         aliased_columns_scope(sql &, const column_id_set &aliaseds);
@@ -265,6 +461,13 @@ public:
         additional_aliased_columns_scope(sql &, const column_id_set &additional_aliaseds);
     };
 
+    // Scratch commands containing just one operand of a write_junction(), by which
+    // duplicate operands are recognized.  They are shared by all the junctions in a
+    // select (including those nested in other junctions' operands), so each operand is
+    // rendered this way only once.
+    //
+    typedef std::map<const abstract_mapper_base *, std::unique_ptr<sql>> operand_renderings;
+
     class nested_select_scope : private boost::noncopyable {
     public:
         explicit nested_select_scope(sql &);
@@ -272,6 +475,9 @@ public:
     private:
         sql &_command;
         const bool _pending;
+        operand_renderings * const _pending_operand_renderings;
+        const window_definition * const _pending_window;
+        const column_mapper * const _pending_filter;
     };
 
     class expression_restriction_scope : private boost::noncopyable {
@@ -282,6 +488,35 @@ public:
         sql &_command;
     };
 
+    // During a filter_scope, the next write_aggregate_call() restricts its call to the rows
+    // where the predicate is true.
+    //
+    class filter_scope : private boost::noncopyable {
+    public:
+        filter_scope(sql &, const column_mapper &predicate);
+        ~filter_scope();
+
+        bool is_used() const;
+    private:
+        sql &_command;
+        const column_mapper * const _pending;
+        const column_mapper * const _previous;
+    };
+
+    // During a window_scope, the next write_aggregate_call() puts the window on its call.
+    //
+    class window_scope : private boost::noncopyable {
+    public:
+        window_scope(sql &, const window_definition &);
+        ~window_scope();
+
+        bool is_used() const;
+    private:
+        sql &_command;
+        const window_definition * const _pending;
+        const window_definition * const _previous;
+    };
+
 protected:
     explicit sql(const database &);
 
@@ -317,6 +552,13 @@ protected:
         const std::vector<thunk> &rhs
     );
 
+    virtual void
+    write_row_value_comparison(
+        const std::string &compare_op,
+        const std::vector<thunk> &lhs,
+        const std::vector<thunk> &rhs
+    );
+
     virtual void
     write_lexicographic_comparison(
         relation r,
@@ -326,6 +568,16 @@ protected:
 
     virtual void write_subquery_exprn(const query_base &);
 
+    virtual void write_order_list(const std::vector<const abstract_mapper_base *> &);
+    virtual void write_function_name(const std::string &);
+
+    // Write '"name" (column, ...) AS (definition)' for each of ctes that hasn't already
+    // been written, each preceded by the ones that its definition refers to.  Returns
+    // false iff it wrote nothing.
+    //
+    virtual bool write_cte_definitions(const std::vector<const cte_base *> &ctes);
+    virtual void write_frame_bound(const frame_bound &);
+
     virtual void write_alter_table(const binomen &table);
 
     static std::string strict_relop(relation);
@@ -333,14 +585,33 @@ protected:
     virtual std::string next_value_reference(const cell &);
 
 private:
+    // The string that write() currently appends to: either _text or, during a
+    // text_insertion_scope, the innermost pending insertion.
+    //
+    std::string &target();
+
+    const sql &operand_rendering(const abstract_mapper_base &operand);
+    bool is_same_rendering(const sql &) const;
+
     const database *_database;
     row _input;
     std::string _text;
+    std::vector<std::pair<marker_t, std::string>> _pending_insertions;
+    parameter_bindings _parameter_bindings;
+    std::vector<std::pair<size_t, parameter_id>> _parameter_slots;  // (index in _input, param)
     universalizable_column_id_set _wanted_aliases;
+    universalizable_column_id_set _referenced_columns;
     column_id_set _aliased_columns;
     bool _nested_select;
     boost::optional<std::string> _implicit_table;
+    const column_mapper *_filter;
+    const window_definition *_window;
+    bool _with_clause_claimed;
+    bool _with_recursive;
+    std::vector<const cte_base *> _referenced_ctes;  // since the last write_cte_definitions()
+    std::set<std::string> _defined_ctes;
     uint32_t _next_subquery_alias;
+    operand_renderings *_operand_renderings;  // only during write_junction()
 };
 
 }
@@ -41,6 +41,22 @@ struct foreign_spec {
 };
 
 
+// How general_table::sample() chooses rows.
+//
+enum class sample_method {
+    system,     // chooses whole storage pages: cheap, but rows stored together are chosen together
+    bernoulli   // chooses each row independently: uniform, but scans the whole table
+};
+
+// For quince internal use only.
+//
+struct table_sample {
+    double _percent;
+    sample_method _method;
+    boost::optional<int64_t> _seed;
+};
+
+
 // Base class of all tables and serial_tables (but not table_aliases).
 //
 class table_base : protected object_owner, public table_interface {
@@ -134,6 +150,7 @@ public:
     virtual const database &get_database() const override   { return _database; }
 
     bool is_open() const                                    { return _is_open; }
+    bool is_sampled() const                                 { return _sample != boost::none; }
     const mapper_factory &get_mapper_factory() const        { return _mapper_factory; }
     const uint64_t table_id() const                         { return _table_id; }
 
@@ -157,23 +174,31 @@ protected:
         _binomen(binomen::split(name, db.get_default_enclosure())),
         _mapper_factory(own_or_null(mc), db.get_mapper_factory()),
         _value_mapper(own(make_value_mapper<Value>())),
-        _sql_delete(own(_database.make_sql())),
+        _quoted_binomen(quoted(_binomen, db)),
         _is_open(false)
-    {
-        const_cast<sql&>(_sql_delete).write_delete_from(_binomen);
-    }
+    {}
 
     const abstract_mapper_base &get_value_mapper_base() const   { return _value_mapper; }
     const abstract_mapper_base &get_key_mapper_base() const     { return *_key_mapper; }
+    bool has_key() const                                        { return _key_mapper != nullptr; }
 
     virtual void specify_key_base(const abstract_mapper_base *);
 
     std::unique_ptr<sql> sql_insert(const row &input);
 
+    // Execute "INSERT INTO <this table> (...) SELECT ...", where the SELECT is source's.
+    //
+    boost::optional<uint64_t> insert_from(const query_base &source) const;
+
     virtual bool might_have_duplicate_rows() const override     { return false; }
 
+    // Make this (a copy of some table) read only a sample of the table's rows.
+    //
+    void set_sample(const table_sample &);
+
 private:
     friend class query_base;
+    friend class conditional_junction_base;
 
     template<typename T>
     std::unique_ptr<abstract_mapper_base>
@@ -185,11 +210,22 @@ private:
     }
 
     template<typename Src> // abstract_mapper_base or row
-    void
+    boost::optional<uint64_t>
     update_with_no_output(
         const abstract_mapper_base &dest,
         const Src &src,
-        const abstract_predicate &
+        const abstract_predicate &,
+        const sql::parameter_bindings &
+    ) const;
+
+    boost::optional<uint64_t>
+    update_with_source(
+        const abstract_mapper_base &dest,
+        const abstract_mapper_base &src,
+        const abstract_query_base &source,
+        const abstract_predicate &on,
+        const abstract_predicate &,
+        const sql::parameter_bindings &
     ) const;
 
     template<typename Src> // abstract_mapper_base or row
@@ -198,6 +234,7 @@ private:
         const abstract_mapper_base &dest,
         const Src &src,
         const abstract_predicate &,
+        const sql::parameter_bindings &,
         const abstract_mapper_base &returning,
         uint32_t fetch_size
     ) const;
@@ -208,25 +245,47 @@ private:
         const abstract_mapper_base &dest,
         const Src &src,
         const abstract_predicate &,
+        const sql::parameter_bindings &,
         const abstract_mapper_base &returning
     ) const;
 
-    void remove_where(const abstract_predicate &) const;
-    void remove_existing_where(const abstract_predicate &) const;
-    bool remove_if_exists_where(const abstract_predicate &) const;
+    // The parameter_bindings args of these functions, and those above, supply values for
+    // any params in the predicate (which are those of the query that it was taken from).
+    //
+    boost::optional<uint64_t> remove_where(const abstract_predicate &, const sql::parameter_bindings &) const;
+    result_stream remove_with_stream_output(
+        const abstract_predicate &,
+        const sql::parameter_bindings &,
+        const abstract_mapper_base &returning,
+        uint32_t fetch_size
+    ) const;
+    void remove_existing_where(const abstract_predicate &, const sql::parameter_bindings &) const;
+    bool remove_if_exists_where(const abstract_predicate &, const sql::parameter_bindings &) const;
 
     boost::optional<column_id> readback_id() const;
 
+    // The text that sql::write_quoted() would write for b, in db's dialect.
+    //
+    static std::string quoted(const binomen &b, const database &db);
+
+    std::unique_ptr<sql>
+    sql_delete(
+        const abstract_predicate &,
+        const sql::parameter_bindings &,
+        const abstract_mapper_base *returning = nullptr
+    ) const;
+
     template<typename Src> // abstract_mapper_base or row
     std::unique_ptr<sql>
     sql_update(
         const abstract_mapper_base &dest,
         const Src &src,
         const abstract_predicate &,
+        const sql::parameter_bindings &,
         const abstract_mapper_base *returning = nullptr
     ) const;
 
-    virtual bool empty_impl(const abstract_predicate &) const = 0;
+    virtual bool empty_impl(const abstract_predicate &, const sql::parameter_bindings &) const = 0;
 
     virtual const serial_mapper * readback_mapper() const   { return nullptr; }
 
@@ -258,9 +317,13 @@ private:
     std::vector<index_spec> _index_specs;
     std::vector<foreign_spec> _foreign_specs;
 
-    const sql &_sql_delete;
+    // Interned result of write_quoted(_binomen), so that the most frequent table reference
+    // (in the FROM clause of every query) costs one append.
+    //
+    const std::string _quoted_binomen;
 
     bool _is_open;
+    boost::optional<table_sample> _sample;
 };
 
 }
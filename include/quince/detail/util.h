@@ -125,6 +125,13 @@ set_difference(const std::set<T> &a, const std::set<T> &b) {
     return result;
 }
 
+template<typename T>
+bool
+intersects(const std::set<T> &a, const std::set<T> &b) {
+    for (const T &x: a)  if (b.count(x))  return true;
+    return false;
+}
+
 template<typename T>
 bool
 is_subset(const std::set<T> &sub, const std::set<T> &super) {
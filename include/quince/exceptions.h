@@ -96,6 +96,31 @@ public:
     explicit ambiguous_nulls_exception();
 };
 
+class keyset_mismatch_exception : public formation_exception {
+public:
+    keyset_mismatch_exception();
+};
+
+class window_exception : public formation_exception {
+public:
+    window_exception();
+};
+
+class filter_exception : public formation_exception {
+public:
+    filter_exception();
+};
+
+class grouping_set_exception : public formation_exception {
+public:
+    grouping_set_exception();
+};
+
+class sample_exception : public formation_exception {
+public:
+    explicit sample_exception(double percent);
+};
+
 class execution_attempt_exception : public exception {
 protected:
     explicit execution_attempt_exception(const std::string &msg);
@@ -131,6 +156,11 @@ public:
     no_primary_key_exception();
 };
 
+class unbound_parameter_exception : public execution_attempt_exception {
+public:
+    unbound_parameter_exception();
+};
+
 class execution_response_exception : public exception {
 protected:
     explicit execution_response_exception(const std::string &msg);
@@ -43,12 +43,49 @@ public:
 
     virtual boost::optional<std::pair<const abstract_mapper_base *, bool>> dissect_as_order_specification() const;
 
+    // If this expression is a junction (see sql::write_junction()) with the given logical
+    // operator, then return its operands; otherwise nullptr.
+    //
+    virtual const std::vector<const abstract_mapper_base *> *dissect_as_junction(const std::string &op) const;
+
+    // If this expression is a test of whether a single column is equal to a known value,
+    // then return that column and value.
+    //
+    virtual boost::optional<std::pair<const column_mapper *, cell>> dissect_as_value_equality(const database &) const;
+
+    // If this expression is a test of whether two single columns are equal, then return them.
+    //
+    virtual boost::optional<std::pair<const column_mapper *, const column_mapper *>> dissect_as_column_equality() const;
+
+    // If this expression is exists(q) then return (nullptr, q); if it is in(lhs, q) then
+    // return (lhs, q).
+    //
+    virtual boost::optional<std::pair<const column_mapper *, const query_base *>> dissect_as_subquery_test() const;
+
+    // False if this expression certainly contains no aggregate function call (so it can be
+    // moved from a subquery's select list into the enclosing query; see query_base::write_select()).
+    // The default is the cautious answer.
+    //
+    virtual bool might_aggregate() const;
+
 protected:
     std::vector<const abstract_mapper_base *>
     own_all(std::vector<std::unique_ptr<const abstract_mapper_base>> &&);
 };
 
 
+// An expressionist for aggregate.filter(predicate): see general_exprn_mapper::filter().
+//
+std::unique_ptr<const abstract_expressionist>
+make_filter_expressionist(const abstract_mapper_base &aggregate, const abstract_mapper<bool> &predicate);
+
+
+// True unless all of mapper's columns are persistent columns or expressions that certainly
+// contain no aggregate function call.
+//
+bool might_aggregate(const abstract_mapper_base &mapper);
+
+
 class exprn_mapper_base : public column_mapper {
 public:
     ~exprn_mapper_base();
@@ -56,6 +93,12 @@ public:
     virtual void write_expression(sql &) const override;
     virtual column_id_set imports() const override;
 
+    const std::vector<const abstract_mapper_base *> *dissect_as_junction(const std::string &op) const;
+    boost::optional<std::pair<const column_mapper *, cell>> dissect_as_value_equality(const database &) const;
+    boost::optional<std::pair<const column_mapper *, const column_mapper *>> dissect_as_column_equality() const;
+    boost::optional<std::pair<const column_mapper *, const query_base *>> dissect_as_subquery_test() const;
+    bool might_aggregate() const;
+
 protected:
     explicit exprn_mapper_base(std::unique_ptr<const abstract_expressionist>);
 
@@ -119,6 +162,22 @@ public:
         return _a_priori_value;
     }
 
+    // For an expression that calls an aggregate function, such as count() or sum(): the
+    // same expression, except that the aggregate function only considers rows where
+    // predicate is true.  So several conditional counts or sums can be computed in one
+    // scan, e.g.:
+    //
+    //      orders.select(count_all.filter(orders->late), sum(orders->amount).filter(orders->paid))
+    //
+    // If the expression calls more than one aggregate function, the filter applies to
+    // the first one that is written.  If it calls none, then writing it throws
+    // filter_exception.
+    //
+    exprn_mapper<Return>
+    filter(const abstract_mapper<bool> &predicate) const {
+        return exprn_mapper<Return>(make_filter_expressionist(*this, predicate));
+    }
+
 protected:
     virtual void to_row(const Return &, row &) const override   { abort(); }
 
@@ -130,6 +189,7 @@ private:
         explicit value_expressionist(const T &v) : _value(v)    {}
         virtual void write_expression(sql &cmd) const override  { cmd.write_value(_value); }
         virtual column_id_set imports() const override          { return {}; }
+        virtual bool might_aggregate() const override           { return false; }
     };
 
     template<typename T>
@@ -42,10 +42,25 @@ struct extrinsic_comparison_expressionist : public abstract_expressionist {
         cmd.write_extrinsic_comparison(_relation, _lhs, r);
     }
 
+    virtual boost::optional<std::pair<const column_mapper *, cell>>
+    dissect_as_value_equality(const database &db) const override {
+        if (_relation != relation::equal  ||  _lhs.size() != 1)  return boost::none;
+
+        row r(&db);
+        _lhs.to_row(_rhs, r);
+        const column_mapper &column = _lhs.only_column();
+        return std::make_pair(&column, *r.find_cell(column.name()));
+    }
+
     virtual column_id_set
     imports() const override {
         return _lhs.imports();
     }
+
+    virtual bool
+    might_aggregate() const override {
+        return quince::might_aggregate(_lhs);
+    }
 };
 
 template<typename T>
@@ -65,6 +80,13 @@ make_intrinsic_comparison_expressionist(
     std::unique_ptr<const abstract_mapper_base> rhs
 );
 
+std::unique_ptr<const abstract_expressionist>
+make_keyset_comparison_expressionist(
+    std::vector<std::unique_ptr<const abstract_mapper_base>> &&orders_hi_to_lo,
+    const std::vector<cell> &key,
+    bool after
+);
+
 
 struct lexicographic_comparison_op {
     lexicographic_comparison_op(relation r, relation converse_r) :
@@ -14,7 +14,9 @@
 #include <quince/exprn_mappers/functions.h>
 #include <quince/exprn_mappers/in.h>
 #include <quince/exprn_mappers/operators.h>
+#include <quince/exprn_mappers/param.h>
 #include <quince/exprn_mappers/scalar.h>
+#include <quince/exprn_mappers/window.h>
 
 #endif
 
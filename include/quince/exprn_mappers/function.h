@@ -17,6 +17,18 @@ make_function_call_expressionist(
     std::vector<std::unique_ptr<const abstract_mapper_base>> &&args
 );
 
+// If distinct is true, the function only considers distinct values of args.  If ordered_by
+// is not null, the function is an ordered-set aggregate, such as percentile_cont(), and
+// ordered_by is the expression in its WITHIN GROUP (ORDER BY ...).
+//
+std::unique_ptr<const abstract_expressionist>
+make_aggregate_call_expressionist(
+    const std::string &function_name,
+    std::vector<std::unique_ptr<const abstract_mapper_base>> &&args,
+    bool distinct = false,
+    std::unique_ptr<const abstract_mapper_base> ordered_by = nullptr
+);
+
 template<typename T>
 exprn_mapper<T>
 function(
@@ -42,6 +54,35 @@ function(
     ));
 }
 
+// Like function(), but for a call of an aggregate function, or of a function that is
+// only valid in a window (see window.h).  The difference is that over() can put a
+// window on it, and filter() can restrict the rows that it considers.
+//
+template<typename T>
+exprn_mapper<T>
+aggregate(
+    const std::string &function_name,
+    const std::vector<const abstract_mapper_base *> &args
+) {
+    return exprn_mapper<T>(make_aggregate_call_expressionist(
+        function_name,
+        clone_all(args)
+    ));
+}
+
+template<typename T, typename Arg, typename... Args>
+exprn_mapper<T>
+aggregate(
+    const std::string &function_name,
+    const Arg &arg,
+    const Args &... args
+) {
+    return exprn_mapper<T>(make_aggregate_call_expressionist(
+        function_name,
+        make_new_mappers(arg, args...)
+    ));
+}
+
 }
 
 #endif
@@ -39,6 +39,41 @@ exprn_mapper<boost::optional<double>> avg(const abstract_mapper<double> &);
 
 exprn_mapper<int64_t> count(const abstract_mapper_base &);
 
+// Counts the distinct non-null values of the argument.
+//
+exprn_mapper<int64_t> count_distinct(const abstract_mapper_base &);
+
+// Sample standard deviation and sample variance.
+//
+exprn_mapper<boost::optional<double>> stddev(const abstract_mapper<int16_t> &);
+exprn_mapper<boost::optional<double>> stddev(const abstract_mapper<int32_t> &);
+exprn_mapper<boost::optional<double>> stddev(const abstract_mapper<int64_t> &);
+exprn_mapper<boost::optional<double>> stddev(const abstract_mapper<float> &);
+exprn_mapper<boost::optional<double>> stddev(const abstract_mapper<double> &);
+
+exprn_mapper<boost::optional<double>> variance(const abstract_mapper<int16_t> &);
+exprn_mapper<boost::optional<double>> variance(const abstract_mapper<int32_t> &);
+exprn_mapper<boost::optional<double>> variance(const abstract_mapper<int64_t> &);
+exprn_mapper<boost::optional<double>> variance(const abstract_mapper<float> &);
+exprn_mapper<boost::optional<double>> variance(const abstract_mapper<double> &);
+
+// The value below which the given fraction (between 0 and 1) of the argument's values
+// fall, interpolating between adjacent values if need be, e.g. percentile_cont(0.5, x) is
+// the median of x.
+//
+exprn_mapper<boost::optional<double>> percentile_cont(double fraction, const abstract_mapper<int16_t> &);
+exprn_mapper<boost::optional<double>> percentile_cont(double fraction, const abstract_mapper<int32_t> &);
+exprn_mapper<boost::optional<double>> percentile_cont(double fraction, const abstract_mapper<int64_t> &);
+exprn_mapper<boost::optional<double>> percentile_cont(double fraction, const abstract_mapper<float> &);
+exprn_mapper<boost::optional<double>> percentile_cont(double fraction, const abstract_mapper<double> &);
+
+exprn_mapper<boost::optional<bool>> bool_and(const abstract_mapper<bool> &);
+exprn_mapper<boost::optional<bool>> bool_or(const abstract_mapper<bool> &);
+
+// The non-null values of the argument, concatenated with delimiter between them.
+//
+exprn_mapper<boost::optional<std::string>> string_agg(const abstract_mapper<std::string> &, const std::string &delimiter);
+
 exprn_mapper<int64_t> sum(const abstract_mapper<int16_t> &);
 exprn_mapper<int64_t> sum(const abstract_mapper<int32_t> &);
 exprn_mapper<int64_t> sum(const abstract_mapper<int64_t> &);
@@ -46,16 +81,26 @@ exprn_mapper<double> sum(const abstract_mapper<float> &);
 exprn_mapper<double> sum(const abstract_mapper<double> &);
 
 
+// In a query made by group(...).rollup(), cube() or grouping_sets(): a bitmask with bit
+// n-1-i set iff the i-th of the n arguments is not grouped in the current row (and so
+// reads as null).  Each argument must be one of the group(...) args.
+//
+template<typename... Mappers>
+exprn_mapper<int32_t>
+grouping(const Mappers &... mappers) {
+    return function<int32_t>("GROUPING", mappers...);
+}
+
 template<typename T>
 exprn_mapper<boost::optional<T>>
 max(const abstract_mapper<T> &m) {
-    return function<boost::optional<T>>("max", m);
+    return aggregate<boost::optional<T>>("max", m);
 }
 
 template<typename T>
 exprn_mapper<boost::optional<T>>
 min(const abstract_mapper<T> &m) {
-    return function<boost::optional<T>>("min", m);
+    return aggregate<boost::optional<T>>("min", m);
 }
 
 }
@@ -26,6 +26,48 @@ make_in_expressionist(
 );
 
 
+template<typename T>
+class in_array_expressionist : public abstract_expressionist {
+public:
+    in_array_expressionist(std::unique_ptr<const abstract_mapper_base> lhs, const std::vector<T> &values) :
+        _lhs(own(lhs)),
+        _values(values)
+    {}
+
+    virtual void
+    write_expression(sql &cmd) const override {
+        std::vector<cell> cells;
+        cells.reserve(_values.size());
+        for (const T &v: _values)  cells.push_back(cmd.get_database().to_cell(v));
+        cmd.write_in_array(_lhs.only_column(), cells);
+    }
+
+    virtual column_id_set imports() const override  { return _lhs.imports(); }
+
+private:
+    const abstract_mapper_base &_lhs;
+    const std::vector<T> _values;
+};
+
+
+// in_array(lhs, values) is equivalent to in(lhs, values[0], values[1], ...), but it
+// doesn't create a mapper per value, and (on backends that support it) it passes the
+// whole vector as one array parameter, so that the text of the SQL doesn't depend on
+// the number of values.
+//
+template<typename T, typename Lhs>
+predicate
+in_array(const Lhs &lhs, const std::vector<T> &values) {
+    exposed_mapper_type<T>::static_forbid_optionals();
+
+    if (values.empty())  return predicate(false);
+
+    return predicate(quince::make_unique<in_array_expressionist<T>>(
+        make_new_mapper_checked<T>(lhs),
+        values
+    ));
+}
+
 template<typename T, typename Lhs>
 predicate
 in(const Lhs &lhs, const std::vector<const abstract_mapper<T> *> &rhs) {
@@ -0,0 +1,72 @@
+#ifndef QUINCE__exprn_mappers__param_h
+#define QUINCE__exprn_mappers__param_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <quince/detail/compiler_specific.h>
+#include <quince/detail/sql.h>
+#include <quince/exprn_mappers/detail/exprn_mapper.h>
+
+
+namespace quince {
+
+std::unique_ptr<const abstract_expressionist>
+make_parameter_expressionist(sql::parameter_id id);
+
+sql::parameter_id
+next_parameter_id();
+
+
+QUINCE_SUPPRESS_MSVC_DOMINANCE_WARNING
+
+// A param<T> is a placeholder for a value of type T, which is not known when the query
+// is built, and is supplied later by query<Value>::bind().  It can be used anywhere an
+// exprn_mapper<T> can, e.g.:
+//
+//      const param<int32_t> lo, hi;
+//      const query<point> q = points.where(points->x >= lo && points->x < hi);
+//
+//      for (const point &p: q.bind(lo, 3).bind(hi, 7))  ...
+//      for (const point &p: q.bind(lo, 10).bind(hi, 20))  ...
+//
+// All the queries that q.bind(...) returns share the SQL that is generated for the first
+// one to be executed; each execution only swaps in the bound values.
+//
+// T must be a single-column type.  Copies of a param refer to the same placeholder.
+//
+template<typename T>
+class param : public exprn_mapper<T> {
+public:
+    param() :
+        param(next_parameter_id())
+    {}
+
+    sql::parameter_id get_parameter_id() const  { return _id; }
+
+
+    // --- Everything from here to end of class is for quince internal use only. ---
+
+    virtual std::unique_ptr<cloneable>
+    clone_impl() const override {
+        return quince::make_unique<param<T>>(*this);
+    }
+
+private:
+    explicit param(sql::parameter_id id) :
+        abstract_mapper_base(boost::none),
+        abstract_mapper<T>(boost::none),
+        exprn_mapper<T>(make_parameter_expressionist(id)),
+        _id(id)
+    {}
+
+    sql::parameter_id _id;
+};
+
+QUINCE_UNSUPPRESS_MSVC_WARNING
+
+}
+
+#endif
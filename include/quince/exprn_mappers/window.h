@@ -0,0 +1,190 @@
+#ifndef QUINCE__exprn_mappers__window_h
+#define QUINCE__exprn_mappers__window_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include <boost/optional.hpp>
+#include <quince/exprn_mappers/detail/exprn_mapper.h>
+#include <quince/exprn_mappers/function.h>
+
+
+namespace quince {
+
+// One end of a window frame: see window<T>::rows() and window<T>::range().
+//
+struct frame_bound {
+    enum class kind { unbounded_preceding, preceding, current_row, following, unbounded_following };
+
+    kind _kind;
+    uint32_t _offset;  // only meaningful for preceding and following
+};
+
+extern const frame_bound unbounded_preceding;
+extern const frame_bound current_row;
+extern const frame_bound unbounded_following;
+frame_bound preceding(uint32_t offset);
+frame_bound following(uint32_t offset);
+
+struct window_frame {
+    bool _range;  // RANGE if true, ROWS if false
+    frame_bound _start;
+    frame_bound _end;
+};
+
+
+// The part of a window<T> that doesn't depend on T: the windowed expression, and the
+// window it's computed over.  A window_definition is never modified once it has been
+// put into a window<T>; each of window<T>'s builder methods makes a new one, which shares
+// the mappers of the old one.
+//
+struct window_definition {
+    std::shared_ptr<const abstract_mapper_base> _windowed;
+    std::vector<std::shared_ptr<const abstract_mapper_base>> _partitions;
+    std::vector<std::shared_ptr<const abstract_mapper_base>> _orders;
+    boost::optional<window_frame> _frame;
+};
+
+std::unique_ptr<const abstract_expressionist>
+make_window_expressionist(std::shared_ptr<const window_definition>);
+
+
+QUINCE_SUPPRESS_MSVC_DOMINANCE_WARNING
+
+// An exprn_mapper<T> for an expression of the form "f(...) OVER (...)", where f is an
+// aggregate function or a window function (such as the ones declared below).  You get
+// one by calling over(), and then refine the window by calling partition_by(), order_by(),
+// rows() and range(), e.g.:
+//
+//      over(sum(sales->amount)).partition_by(sales->region).order_by(sales->day).rows(unbounded_preceding, current_row)
+//
+// The windowed expression may wrap its aggregate call in other operations (as sum() and
+// avg() do), in which case the window applies to the first aggregate call that is
+// written.  If there is none then writing the expression throws window_exception.
+//
+// Windows are computed after WHERE, GROUP BY and HAVING, so a window<T> can be used in a
+// select list or an order specification, but a query that selects one and is then
+// restricted further will compute the window in a subquery.
+//
+template<typename T>
+class window : public exprn_mapper<T> {
+public:
+    explicit window(const abstract_mapper<T> &windowed) :
+        window(make_definition(windowed))
+    {}
+
+    virtual std::unique_ptr<cloneable>
+    clone_impl() const override {
+        return quince::make_unique<window<T>>(*this);
+    }
+
+    template<typename... Mappers>
+    window<T>
+    partition_by(const Mappers &... mappers) const {
+        auto result = std::make_shared<window_definition>(*_definition);
+        append(result->_partitions, make_new_mappers(mappers...));
+        return window<T>(result);
+    }
+
+    // Each of orders can be prefixed with unary - to make it descending, as with
+    // query::order().
+    //
+    template<typename... Orders>
+    window<T>
+    order_by(const Orders &... orders) const {
+        auto result = std::make_shared<window_definition>(*_definition);
+        append(result->_orders, make_new_mappers(orders...));
+        return window<T>(result);
+    }
+
+    window<T>
+    rows(const frame_bound &start, const frame_bound &end) const {
+        return with_frame(window_frame{ false, start, end });
+    }
+
+    window<T>
+    range(const frame_bound &start, const frame_bound &end) const {
+        return with_frame(window_frame{ true, start, end });
+    }
+
+private:
+    explicit window(const std::shared_ptr<const window_definition> &definition) :
+        abstract_mapper_base(boost::none),
+        abstract_mapper<T>(boost::none),
+        exprn_mapper<T>(make_window_expressionist(definition)),
+        _definition(definition)
+    {}
+
+    static std::shared_ptr<const window_definition>
+    make_definition(const abstract_mapper<T> &windowed) {
+        auto result = std::make_shared<window_definition>();
+        result->_windowed = clone(windowed);
+        return result;
+    }
+
+    static void
+    append(
+        std::vector<std::shared_ptr<const abstract_mapper_base>> &dest,
+        std::vector<std::unique_ptr<const abstract_mapper_base>> &&src
+    ) {
+        for (auto &m: src)  dest.push_back(std::move(m));
+    }
+
+    window<T>
+    with_frame(const window_frame &frame) const {
+        auto result = std::make_shared<window_definition>(*_definition);
+        result->_frame = frame;
+        return window<T>(result);
+    }
+
+    std::shared_ptr<const window_definition> _definition;
+};
+
+QUINCE_UNSUPPRESS_MSVC_WARNING
+
+
+template<typename T>
+window<T>
+over(const abstract_mapper<T> &windowed) {
+    return window<T>(windowed);
+}
+
+
+// Window functions.  These are only meaningful inside over().
+//
+exprn_mapper<int64_t> row_number();
+exprn_mapper<int64_t> rank();
+exprn_mapper<int64_t> dense_rank();
+
+template<typename T>
+exprn_mapper<boost::optional<T>>
+lag(const abstract_mapper<T> &m, int32_t offset = 1) {
+    return aggregate<boost::optional<T>>("lag", m, offset);
+}
+
+template<typename T>
+exprn_mapper<boost::optional<T>>
+lead(const abstract_mapper<T> &m, int32_t offset = 1) {
+    return aggregate<boost::optional<T>>("lead", m, offset);
+}
+
+template<typename T>
+exprn_mapper<T>
+first_value(const abstract_mapper<T> &m) {
+    return aggregate<T>("first_value", m);
+}
+
+template<typename T>
+exprn_mapper<T>
+last_value(const abstract_mapper<T> &m) {
+    return aggregate<T>("last_value", m);
+}
+
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef QUINCE__paginator_h
+#define QUINCE__paginator_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <functional>
+#include <vector>
+#include <boost/optional.hpp>
+#include <quince/query.h>
+
+
+namespace quince {
+
+// Fetches the results of an ordered query one page at a time, using query::after() rather
+// than skip(), so that each page costs the same however deep it is.
+//
+// key_of must extract, from a result, the values of the query's order() columns (see
+// query::after()).  The cursor is the key of the last result returned so far; to resume
+// pagination later, save it and pass it to a new paginator's constructor.
+//
+template<typename Value, typename Key>
+class paginator {
+public:
+    paginator(
+        const query<Value> &ordered,
+        std::function<Key(const Value &)> key_of,
+        uint32_t page_size,
+        const boost::optional<Key> &cursor = boost::none
+    ) :
+        _query(ordered),
+        _key_of(key_of),
+        _page_size(page_size),
+        _cursor(cursor),
+        _is_exhausted(false)
+    {}
+
+    // Returns the next page, which is empty iff there are no more results.
+    //
+    std::vector<Value>
+    next_page() {
+        std::vector<Value> result;
+        if (_is_exhausted)  return result;
+
+        const query<Value> q = _cursor ? _query.after(*_cursor) : _query;
+        for (const Value &v: q.limit(_page_size).fetch_size(_page_size))
+            result.push_back(v);
+
+        if (result.size() < _page_size)  _is_exhausted = true;
+        if (! result.empty())  _cursor = _key_of(result.back());
+        return result;
+    }
+
+    const boost::optional<Key> &cursor() const  { return _cursor; }
+    bool is_exhausted() const                   { return _is_exhausted; }
+
+private:
+    const query<Value> _query;
+    const std::function<Key(const Value &)> _key_of;
+    const uint32_t _page_size;
+    boost::optional<Key> _cursor;
+    bool _is_exhausted;
+};
+
+}
+
+#endif
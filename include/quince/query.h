@@ -7,19 +7,35 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <assert.h>
+#include <limits>
+#include <tuple>
+#include <vector>
 #include <boost/optional.hpp>
 #include <quince/detail/abstract_query.h>
 #include <quince/detail/compiler_specific.h>
 #include <quince/detail/query_base.h>
 #include <quince/detail/util.h>
+#include <quince/exprn_mappers/exists.h>
 #include <quince/exprn_mappers/in.h>
 #include <quince/exprn_mappers/functions.h>
+#include <quince/exprn_mappers/param.h>
+#include <quince/exprn_mappers/window.h>
 #include <quince/database.h>
 
 
 namespace quince {
 
 
+// What query::page() and page_after() return: one page of a query's results, and the
+// total number of results on all pages.
+//
+template<typename Value>
+struct result_page {
+    std::vector<Value> _rows;
+    uint64_t _total;
+};
+
+
 QUINCE_SUPPRESS_MSVC_DOMINANCE_WARNING
 
 template<typename Value>
@@ -45,6 +61,9 @@ public:
     using query_base::select;
     using query_base::group;
     using query_base::update;
+    using query_base::update_from;
+    using query_base::update_returning;
+    using query_base::remove_returning;
 
     virtual uint64_t
     size() const override {
@@ -53,7 +72,26 @@ public:
 
     virtual bool
     empty() const override {
-        return a_priori_empty() || countable_equivalent().evaluate(quince::empty);
+        return a_priori_empty() || ! countable_equivalent().limit(1).fetch_any();
+    }
+
+    // Returns size(), or n+1 if size() is greater than n, without counting any rows beyond
+    // the (n+1)th.  So size_up_to(999) == 1000 means "1000 or more".
+    //
+    virtual uint64_t
+    size_up_to(uint32_t n) const override {
+        if (a_priori_empty())  return 0ULL;
+        if (n == std::numeric_limits<uint32_t>::max())  return size();
+        return countable_equivalent().limit(n+1).wrapped().evaluate(quince::count_all);
+    }
+
+    // Returns the database's estimate of size(), if it can make one cheaply (see
+    // database::estimate_row_count()), otherwise boost::none, so that the caller can
+    // choose whether to pay for size() or size_up_to().
+    //
+    virtual boost::optional<uint64_t>
+    size_estimate() const override {
+        return fetch_size_estimate();
     }
 
     // TODO: In order to avoid unnecessary query copies, I want to implement limit() as
@@ -97,6 +135,18 @@ public:
         return result;
     }
 
+    // Returns a copy of this query in which p has the given value.  The copy shares
+    // its generated SQL with this query, so binding and re-binding params is a cheap way
+    // to execute the same statement many times with different values.
+    //
+    template<typename T, typename V>
+    query<Value>
+    bind(const param<T> &p, const V &value) const {
+        query<Value> result(*this);
+        result.add_binding(p.get_parameter_id(), get_database().to_cell(T(value)));
+        return result;
+    }
+
     virtual query<Value>
     where(const abstract_predicate &pred) const override {
         query<Value> result = predicational_equivalent();
@@ -109,6 +159,148 @@ public:
         return where(predicate(b));
     }
 
+    // semi_join(that, pred) returns the rows of this query for which some row of that
+    // satisfies pred, and anti_join(that, pred) returns the rows for which none does.
+    // Unlike inner_join() or left_join(), the result has this query's value type, and
+    // none of that's columns are fetched.  The SQL is WHERE [NOT] EXISTS (SELECT 1 ...).
+    //
+    template<typename V>
+    query<Value>
+    semi_join(const abstract_query<V> &that, const abstract_predicate &pred) const {
+        return where(exists(that.where(pred)));
+    }
+
+    template<typename V>
+    query<Value>
+    anti_join(const abstract_query<V> &that, const abstract_predicate &pred) const {
+        return where(! exists(that.where(pred)));
+    }
+
+    // Returns a copy of this query in which suitable exists(q) and in(x, q) conditions in
+    // the where() clause are evaluated as joins with q, so that a correlated q isn't
+    // re-evaluated for every row.  q is suitable if it is a table's rows filtered by a
+    // predicate, and (for exists()) the only references to the outer query are equalities,
+    // e.g. exists(orders.where(orders->customer == customers->id && orders->open)).
+    // The output is the same either way; this only gives the DBMS a different plan.
+    //
+    query<Value>
+    decorrelate() const {
+        query<Value> result(*this);
+        result.set_decorrelate();
+        return result;
+    }
+
+    // after(k) restricts this query to the rows that come after a row whose order()
+    // columns hold k, and before(k) to the rows that come before it.  So if q is ordered
+    // on a unique key, then q.after(k).limit(n) is the page that follows the row with
+    // key k --and, unlike skip(), the server can seek to it with an index.
+    //
+    // Key must map to exactly the columns of this query's order() list, in order
+    // (e.g. a std::tuple with one element per order() argument), otherwise we throw
+    // keyset_mismatch_exception.  Call after() or before() ahead of limit().
+    //
+    template<typename Key>
+    query<Value>
+    after(const Key &last_seen) const {
+        return where(keyset_predicate(get_database().to_cells(last_seen), true));
+    }
+
+    template<typename Key>
+    query<Value>
+    before(const Key &first_seen) const {
+        return where(keyset_predicate(get_database().to_cells(first_seen), false));
+    }
+
+    // for_update() and for_share() make the query lock the rows it reads, until the end of
+    // the current transaction: for_update() against other transactions' updates and
+    // locks, for_share() only against their updates and for_update() locks.
+    //
+    // skip_locked() makes the query leave out rows that another transaction has locked,
+    // rather than wait for them, and nowait() makes it fail instead.  Either of these
+    // implies for_update() unless for_share() has been called.
+    //
+    // All of these require database::supports_row_locking(), otherwise they throw
+    // unsupported_exception.
+    //
+    virtual query<Value>
+    for_update() const override {
+        query<Value> result(*this);
+        result.set_row_lock(row_lock_type::update);
+        return result;
+    }
+
+    virtual query<Value>
+    for_share() const override {
+        query<Value> result(*this);
+        result.set_row_lock(row_lock_type::share);
+        return result;
+    }
+
+    virtual query<Value>
+    skip_locked() const override {
+        query<Value> result(*this);
+        result.set_row_lock_wait(row_lock_wait::skip_locked);
+        return result;
+    }
+
+    virtual query<Value>
+    nowait() const override {
+        query<Value> result(*this);
+        result.set_row_lock_wait(row_lock_wait::nowait);
+        return result;
+    }
+
+    // Takes up to n of this query's rows that no other transaction has locked, sets dest
+    // to src in each of them, and returns them, all in one statement, like:
+    //
+    //      UPDATE jobs SET ... WHERE id IN (SELECT id FROM jobs WHERE ... LIMIT n FOR UPDATE SKIP LOCKED) RETURNING ...
+    //
+    // So any number of workers can take jobs from the same queue without waiting for each
+    // other or taking the same job twice, e.g.:
+    //
+    //      for (const job &j: jobs.where(jobs->worker == 0).order(jobs->id).claim(10, jobs->worker, my_id))
+    //
+    // Within a transaction, the claimed rows stay locked until it ends.
+    //
+    template<typename T, typename Source>
+    returned_rows<Value>
+    claim(uint32_t n, const abstract_mapper<T> &dest, const Source &src) const {
+        return limit(n).skip_locked().update_returning(dest, src, _value_mapper);
+    }
+
+    // page(offset, n) returns the results that skip(offset).limit(n) would, together with
+    // size(), and page_after(cursor, n) returns the results that after(cursor).limit(n)
+    // would, together with size().
+    //
+    // If the database supports_window_functions(), then the total is computed as
+    // "COUNT(*) OVER ()" in the same statement as the page, so the results are only
+    // scanned once.  (The exception is an empty page, from which the total can't be
+    // read, so then it's counted separately.)  Otherwise the page and the total are
+    // fetched by two statements, one after the other.
+    //
+    result_page<Value>
+    page(uint32_t offset, uint32_t n) const {
+        if (! get_database().supports_window_functions())
+            return result_page<Value>{ collect(skip(offset).limit(n).fetch_size(n)), size() };
+
+        return split_page(with_total().skip(offset).limit(n).fetch_size(n));
+    }
+
+    template<typename Key>
+    result_page<Value>
+    page_after(const Key &cursor, uint32_t n) const {
+        const predicate after_cursor = keyset_predicate(get_database().to_cells(cursor), true);
+        if (! get_database().supports_window_functions())
+            return result_page<Value>{ collect(where(after_cursor).limit(n).fetch_size(n)), size() };
+
+        // The total must be counted before the cursor's restriction is applied, so the
+        // restriction goes in an enclosing query, which must repeat the order.
+        //
+        query<std::tuple<Value, int64_t>> counted = with_total().where(after_cursor);
+        counted.add_orders(clone_all(all_orders_hi_to_lo()));
+        return split_page(counted.limit(n).fetch_size(n));
+    }
+
     template<typename... T>
     query<Value>
     order(const abstract_mapper<T> &... orders) const {
@@ -172,10 +364,10 @@ public:
     virtual query<Value> except(const query<Value> &rhs) const override         { return combine(combination_type::except, false, rhs); }
     virtual query<Value> except_all(const query<Value> &rhs) const override     { return combine(combination_type::except, true, rhs); }
 
-    virtual void remove() override                  { query_base::remove(); }
-    virtual void remove_existing() override         { query_base::remove_existing(); }
-    virtual bool remove_if_exists() override        { return query_base::remove_if_exists(); }
-    virtual std::string to_string() const override  { return query_base::to_string(); }
+    virtual boost::optional<uint64_t> remove() override { return query_base::remove(); }
+    virtual void remove_existing() override             { query_base::remove_existing(); }
+    virtual bool remove_if_exists() override            { return query_base::remove_if_exists(); }
+    virtual std::string to_string() const override      { return query_base::to_string(); }
 
 
     // --- Everything from here to end of class is for quince internal use only. ---
@@ -185,10 +377,20 @@ public:
         return quince::make_unique<query<Value>>(*this);
     }
 
+    // Like bind(), for each of the given bindings.
+    //
+    query<Value>
+    bind_all(const sql::parameter_bindings &bindings) const {
+        query<Value> result(*this);
+        for (const auto &b: bindings)  result.add_binding(b.first, b.second);
+        return result;
+    }
+
 private:
-    friend class grouping;
+    friend class grouping_clause;
     template<typename> friend class abstract_query;
     friend class query_base;
+    friend class query_batch;
     template<typename> friend class query;
 
     // If q is some other query, and you call q.select(...), it comes here to make the new query:
@@ -202,10 +404,40 @@ private:
 
     // If q is some other query, and you call q.group(...).select(...), it comes here to make the new query:
     //
-    query(const query_base &that, const value_mapper &selection, std::vector<std::unique_ptr<const abstract_mapper_base>> &&group_by) :
+    query(
+        const query_base &that,
+        const value_mapper &selection,
+        std::vector<std::unique_ptr<const abstract_mapper_base>> &&group_by,
+        grouping_type type,
+        const std::vector<std::vector<size_t>> &grouping_sets
+    ) :
         query(that, selection)
     {
-        set_group_by(std::move(group_by));
+        set_group_by(std::move(group_by), type, grouping_sets);
+    }
+
+    query<std::tuple<Value, int64_t>>
+    with_total() const {
+        return select(_value_mapper, over(count_all));
+    }
+
+    static std::vector<Value>
+    collect(const query<Value> &q) {
+        std::vector<Value> result;
+        for (const Value &v: q)  result.push_back(v);
+        return result;
+    }
+
+    result_page<Value>
+    split_page(const query<std::tuple<Value, int64_t>> &counted) const {
+        result_page<Value> result;
+        boost::optional<uint64_t> total;
+        for (const std::tuple<Value, int64_t> &r: counted) {
+            result._rows.push_back(std::get<0>(r));
+            total = std::get<1>(r);
+        }
+        result._total = total ? *total : size();
+        return result;
     }
 
     query<Value>
@@ -353,6 +585,7 @@ public:
 
 private:
     friend class query<Value>;
+    friend class returned_rows<Value>;
 
     query_iterator(const abstract_mapper<Value> &mapper, const database &database) :
         query_iterator_base(database),
@@ -383,6 +616,38 @@ private:
     std::unique_ptr<const Value> _value;
 };
 
+
+// What update_returning() and remove_returning() return: the output of a statement that
+// has already been executed, to be iterated over once.
+//
+template<typename Value>
+class returned_rows {
+public:
+    // typedefs for STL compliance:
+    //
+    typedef Value value_type;
+    typedef query_iterator<Value> iterator;
+    typedef iterator const_iterator;
+
+    iterator begin() const  { return _begin; }
+    iterator end() const    { return iterator(*_begin._mapper, _database); }
+
+
+    // --- Everything from here to end of class is for quince internal use only. ---
+
+    returned_rows(const abstract_mapper<Value> &mapper, const database &db, const result_stream &rs) :
+        _database(db),
+        _begin(mapper, db)
+    {
+        _begin.init(rs);
+        _begin.advance();
+    }
+
+private:
+    const database &_database;
+    iterator _begin;
+};
+
 }
 
 #endif
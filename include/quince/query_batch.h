@@ -0,0 +1,189 @@
+#ifndef QUINCE__query_batch_h
+#define QUINCE__query_batch_h
+
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <quince/exceptions.h>
+#include <quince/query.h>
+
+
+namespace quince {
+
+class batch_state;
+class query_batch;
+
+// What query_batch::add() etc. return: a handle on one query's output, which is available
+// once the batch has been executed.
+//
+template<typename T>
+class batch_result {
+public:
+    // The query's output.  If the batch hasn't been executed yet, this executes it.
+    //
+    const T &
+    get() const {
+        if (! _slot->_is_ready)  execute();
+        return _slot->_value;
+    }
+
+    bool is_ready() const   { return _slot->_is_ready; }
+
+private:
+    friend class query_batch;
+
+    struct slot {
+        explicit slot(const T &initial) : _value(initial), _is_ready(false) {}
+
+        T _value;
+        bool _is_ready;
+    };
+
+    batch_result(const std::shared_ptr<batch_state> &batch, const std::shared_ptr<slot> &s) :
+        _batch(batch),
+        _slot(s)
+    {}
+
+    void execute() const;
+
+    const std::shared_ptr<batch_state> _batch;
+    const std::shared_ptr<slot> _slot;
+};
+
+
+// The queries of a query_batch that haven't been executed yet.  It's shared by the
+// query_batch and its batch_results.
+//
+class batch_state : private boost::noncopyable {
+private:
+    friend class query_batch;
+    template<typename> friend class batch_result;
+
+    struct entry {
+        std::unique_ptr<const sql> _cmd;  // nullptr if the query is a priori empty
+        uint32_t _fetch_size;
+        std::function<void(const row &)> _receive;
+        std::function<void()> _finish;
+        std::function<void()> _reset;   // discard anything received by an exec() that failed
+    };
+
+    explicit batch_state(const database &database) :
+        _database(database)
+    {}
+
+    void exec();
+
+    const database &_database;
+    std::vector<entry> _pending;
+};
+
+
+// A query_batch collects several independent queries, and then executes them all together,
+// so that a backend that supports it can send them to the DBMS in one round trip, rather
+// than one round trip per query (see abstract_session_impl::exec_batch_with_output()), e.g.:
+//
+//      query_batch batch(db);
+//      const batch_result<uint64_t> n_cities = batch.add_size(cities);
+//      const batch_result<boost::optional<country>> home = batch.add_get(countries.where(countries->id == 1));
+//      const batch_result<std::vector<city>> big = batch.add(cities.where(cities->population > 1000000));
+//      batch.exec();
+//
+// add_size() and add_get() produce what query::size() and query::get() would.  Any handle's
+// get() executes the batch, if that hasn't happened yet.  Queries added after exec() form a
+// new batch, which is executed by the next exec() or handle get().  If exec() throws, the
+// queries remain pending, so a later exec() will try them again.
+//
+// The handles share the batch's pending queries, so a handle's get() still works after the
+// query_batch itself is destroyed (but not after the database is).
+//
+// The batch is executed on the session that the calling thread is using for the database
+// (which is the session of the current transaction, if any).
+//
+class query_batch : private boost::noncopyable {
+public:
+    explicit query_batch(const database &database) :
+        _state(new batch_state(database))
+    {}
+
+    template<typename Value>
+    batch_result<std::vector<Value>>
+    add(const abstract_query<Value> &q) {
+        return add_entry(as_query(q), std::vector<Value>(), [](std::vector<Value> &rows, Value &&v) {
+            rows.push_back(std::move(v));
+        });
+    }
+
+    template<typename Value>
+    batch_result<boost::optional<Value>>
+    add_get(const abstract_query<Value> &q) {
+        return add_entry(as_query(q).limit(1), boost::optional<Value>(), [](boost::optional<Value> &first, Value &&v) {
+            if (! first)  first = std::move(v);
+        });
+    }
+
+    template<typename Value>
+    batch_result<uint64_t>
+    add_size(const abstract_query<Value> &q) {
+        return add_entry(as_query(q).countable_equivalent().select(count_all), uint64_t(0), [](uint64_t &size, int64_t &&n) {
+            size = n;
+        });
+    }
+
+    // Execute all the queries that have been added since the last exec().
+    //
+    void exec()     { _state->exec(); }
+
+private:
+    // If q is a query, return a copy of it, otherwise promote it to a query.
+    //
+    template<typename Value>
+    static query<Value>
+    as_query(const abstract_query<Value> &q) {
+        if (auto p = dynamic_cast<const query<Value> *>(&q))
+            return *p;
+        return query<Value>(q);
+    }
+
+    template<typename Value, typename T, typename Receive>
+    batch_result<T>
+    add_entry(const query<Value> &q, const T &initial, Receive receive) {
+        if (q.get_database() != _state->_database)  throw cross_database_query_exception();
+
+        typedef typename batch_result<T>::slot slot;
+        const auto s = std::make_shared<slot>(initial);
+        const auto source = std::make_shared<const query<Value>>(q);
+
+        batch_state::entry e;
+        e._fetch_size = q._fetch_size;
+        if (! q.a_priori_empty())  e._cmd = q.make_bound_select();
+        e._receive = [s, source, receive](const row &r) {
+            receive(s->_value, source->get_value_mapper().abstract_mapper<Value>::from_row(r));
+        };
+        e._finish = [s] { s->_is_ready = true; };
+        e._reset = [s, initial] { s->_value = initial; };
+        _state->_pending.push_back(std::move(e));
+
+        return batch_result<T>(_state, s);
+    }
+
+    const std::shared_ptr<batch_state> _state;
+};
+
+
+template<typename T>
+void
+batch_result<T>::execute() const {
+    _batch->exec();
+}
+
+}
+
+#endif
@@ -10,11 +10,15 @@
 #include <quince/detail/junction.h>
 #include <quince/exprn_mappers/expressions.h>
 #include <quince/mappers/mappers.h>
+#include <quince/advisory_lock.h>
+#include <quince/cte.h>
 #include <quince/database.h>
 #include <quince/define_mapper.h>
 #include <quince/exceptions.h>
 #include <quince/mapping_customization.h>
+#include <quince/paginator.h>
 #include <quince/query.h>
+#include <quince/query_batch.h>
 #include <quince/serial.h>
 #include <quince/table.h>
 #include <quince/table_alias.h>
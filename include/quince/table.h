@@ -39,6 +39,28 @@ public:
         return table_alias<Value>(*this);
     }
 
+    // A query whose output is a random sample of about percent% of this table's rows,
+    // chosen afresh each time the query is executed, unless a seed is given.  It can be used
+    // like any other query, and this table's mappers still refer to its columns, e.g.:
+    //
+    //      const uint64_t estimate = 100 * people.sample(1).where(people->age > 40).size();
+    //
+    // If the DBMS supports TABLESAMPLE with the given method, then that is used.  Otherwise
+    // each row is chosen independently, by a random test in a subquery (see
+    // sql::write_random_test()), and a seed can't be honoured (see
+    // database::supports_table_sample()).
+    //
+    query<Value>
+    sample(
+        double percent,
+        sample_method method = sample_method::system,
+        const boost::optional<int64_t> &seed = boost::none
+    ) const {
+        const std::unique_ptr<general_table<Value>> sampled = clone(*this);
+        sampled->set_sample({percent, method, seed});
+        return query<Value>(*sampled);
+    }
+
 
     // --- Everything from here to end of class is for quince internal use only. ---
 
@@ -95,8 +117,8 @@ private:
     }
 
     virtual bool
-    empty_impl(const abstract_predicate &pred) const override {
-        return this->where(pred).empty();
+    empty_impl(const abstract_predicate &pred, const sql::parameter_bindings &bindings) const override {
+        return this->where(pred).bind_all(bindings).empty();
     }
 
     const value_mapper &_value_mapper;
@@ -136,6 +158,24 @@ public:
         this->get_database().get_session()->exec(* this->sql_insert(input));
     }
 
+    // Copy all the output of source into this table, by means of a single INSERT ... SELECT
+    // statement, so the rows never leave the server.  Returns the number of rows inserted,
+    // if the database reports it (see database::reports_row_counts()).
+    //
+    boost::optional<uint64_t>
+    insert(const abstract_query<Value> &source) {
+        return this->insert_from(query<Value>(source));
+    }
+
+    // Same, except that the rows to be inserted are source_mapper's values, for each row
+    // of source.  (source_mapper's value_type must be Value.)
+    //
+    template<typename T, typename Mapper>
+    boost::optional<uint64_t>
+    insert(const abstract_query<T> &source, const Mapper &source_mapper) {
+        return insert(source.select(source_mapper));
+    }
+
     using general_table<Value>::specify_key;
     using general_table<Value>::specify_key_from_ptkm;
 
@@ -0,0 +1,100 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <thread>
+#include <quince/advisory_lock.h>
+#include <quince/database.h>
+#include <quince/exceptions.h>
+#include <quince/detail/row.h>
+#include <quince/detail/sql.h>
+#include <quince/transaction.h>
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+using std::unique_ptr;
+
+
+namespace quince {
+
+advisory_lock::advisory_lock(const database &database, int64_t key, advisory_lock_scope scope) :
+    _database(database),
+    _key(key),
+    _scope(scope),
+    _session(database.get_session()),
+    _owns_lock(false)
+{
+    acquire();
+}
+
+advisory_lock::advisory_lock(const database &database, int64_t key, std::try_to_lock_t, advisory_lock_scope scope) :
+    _database(database),
+    _key(key),
+    _scope(scope),
+    _session(database.get_session()),
+    _owns_lock(false)
+{
+    try_acquire();
+}
+
+advisory_lock::advisory_lock(const database &database, int64_t key, milliseconds timeout, advisory_lock_scope scope) :
+    _database(database),
+    _key(key),
+    _scope(scope),
+    _session(database.get_session()),
+    _owns_lock(false)
+{
+    const steady_clock::time_point deadline = steady_clock::now() + timeout;
+    milliseconds pause(1);
+    while (! try_acquire()) {
+        const steady_clock::time_point now = steady_clock::now();
+        if (now >= deadline)  break;
+
+        std::this_thread::sleep_for(std::min<steady_clock::duration>(pause, deadline - now));
+        pause = std::min(pause * 2, milliseconds(100));
+    }
+}
+
+advisory_lock::~advisory_lock() {
+    try {
+        if (_owns_lock  &&  _scope == advisory_lock_scope::session)  unlock();
+    } catch (...) {}
+}
+
+void
+advisory_lock::unlock() {
+    if (_scope != advisory_lock_scope::session)  throw unsupported_exception();
+    if (! _owns_lock)  return;
+
+    const unique_ptr<sql> cmd = _database.make_sql();
+    cmd->write_advisory_unlock(_key);
+    _session->exec(*cmd);
+    _owns_lock = false;
+}
+
+void
+advisory_lock::acquire() {
+    if (_scope == advisory_lock_scope::transaction  &&  ! transaction::current_for(_database))
+        throw no_current_txn_exception();
+
+    const unique_ptr<sql> cmd = _database.make_sql();
+    cmd->write_advisory_lock(_key, _scope);
+    _session->exec(*cmd);
+    _owns_lock = true;
+}
+
+bool
+advisory_lock::try_acquire() {
+    if (_scope == advisory_lock_scope::transaction  &&  ! transaction::current_for(_database))
+        throw no_current_txn_exception();
+
+    const unique_ptr<sql> cmd = _database.make_sql();
+    cmd->write_try_advisory_lock(_key, _scope);
+    const unique_ptr<row> output = _session->exec_with_one_output(*cmd);
+    _owns_lock = output != nullptr  &&  output->get<bool>();
+    return _owns_lock;
+}
+
+}
@@ -82,6 +82,10 @@ size_t cell::size() const {
     return _bytes.size();
 }
 
+bool cell::operator==(const cell &that) const {
+    return _type == that._type  &&  _is_binary == that._is_binary  &&  _bytes == that._bytes;
+}
+
 
 void cell::set_type(column_type type) {
     _type = type;
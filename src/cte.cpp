@@ -0,0 +1,35 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <quince/cte.h>
+#include <quince/detail/sql.h>
+
+
+namespace quince {
+
+cte_base::~cte_base()
+{}
+
+void
+cte_base::write_table_reference(sql &cmd) const {
+    cmd.write_cte_reference(*this);
+}
+
+column_id_set
+cte_base::aliased_columns() const {
+    return {};
+}
+
+void
+cte_base::for_each_column(std::function<void(const column_mapper &)> op) const {
+    _value_mapper.for_each_column(op);
+}
+
+bool
+cte_base::might_have_duplicate_rows() const {
+    return _definition == nullptr  ||  _is_recursive  ||  _definition->might_have_duplicate_rows();
+}
+
+}
@@ -111,4 +111,54 @@ database::max_column_name_length() const {
     return boost::none;
 }
 
+bool
+database::supports_row_value_comparison() const {
+    return false;
+}
+
+optional<uint64_t>
+database::estimate_row_count(const sql &) const {
+    return boost::none;
+}
+
+bool
+database::reports_row_counts() const {
+    return false;
+}
+
+bool
+database::supports_update_from() const {
+    return false;
+}
+
+bool
+database::supports_lateral_join() const {
+    return false;
+}
+
+bool
+database::supports_aggregate_filter() const {
+    return false;
+}
+
+bool
+database::supports_grouping_sets() const {
+    return false;
+}
+
+bool
+database::supports_row_locking() const {
+    return false;
+}
+
+bool
+database::supports_window_functions() const {
+    return false;
+}
+
+bool
+database::supports_table_sample(sample_method) const {
+    return false;
+}
+
 }
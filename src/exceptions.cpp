@@ -95,6 +95,26 @@ ambiguous_nulls_exception::ambiguous_nulls_exception() :
     formation_exception("type that allows all NULLs used in the part of a join that gives another interpretation to all NULLs")
 {}
 
+keyset_mismatch_exception::keyset_mismatch_exception() :
+    formation_exception("key passed to after() or before() does not match the columns of the query's order()")
+{}
+
+window_exception::window_exception() :
+    formation_exception("expression passed to over() contains no aggregate or window function call")
+{}
+
+filter_exception::filter_exception() :
+    formation_exception("expression on which filter() was called contains no aggregate function call")
+{}
+
+grouping_set_exception::grouping_set_exception() :
+    formation_exception("grouping_sets() was given no sets, or a position that is not that of any group() argument")
+{}
+
+sample_exception::sample_exception(double percent) :
+    formation_exception("sample() was given " + to_string(percent) + " percent, which is not between 0 and 100")
+{}
+
 execution_attempt_exception::execution_attempt_exception(const string &msg) :
     exception(msg)
 {}
@@ -124,6 +144,10 @@ no_primary_key_exception::no_primary_key_exception() :
     execution_attempt_exception("attempt to open a table with no primary key")
 {}
 
+unbound_parameter_exception::unbound_parameter_exception() :
+    execution_attempt_exception("attempt to execute a query with a param that has no value bound to it")
+{}
+
 
 execution_response_exception::execution_response_exception(const string &msg) :
     exception(msg)
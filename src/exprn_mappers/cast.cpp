@@ -38,6 +38,11 @@ make_cast_expressionist(
         imports() const override {
             return _arg.imports();
         }
+
+        virtual bool
+        might_aggregate() const override {
+            return quince::might_aggregate(_arg);
+        }
     };
 
     return quince::make_unique<expressionist>(arg, ctf);
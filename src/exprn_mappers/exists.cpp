@@ -27,6 +27,11 @@ make_exists_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_subquery_exists(_query); }
         virtual column_id_set imports() const override          { return _query.imports(); }
+
+        virtual boost::optional<std::pair<const column_mapper *, const query_base *>>
+        dissect_as_subquery_test() const override {
+            return std::make_pair(static_cast<const column_mapper *>(nullptr), &_query);
+        }
     };
 
     return quince::make_unique<expressionist>(query);
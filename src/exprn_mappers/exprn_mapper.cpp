@@ -22,6 +22,31 @@ abstract_expressionist::dissect_as_order_specification() const {
     return boost::none;
 }
 
+const vector<const abstract_mapper_base *> *
+abstract_expressionist::dissect_as_junction(const string &op) const {
+    return nullptr;
+}
+
+optional<std::pair<const column_mapper *, cell>>
+abstract_expressionist::dissect_as_value_equality(const database &) const {
+    return boost::none;
+}
+
+optional<std::pair<const column_mapper *, const column_mapper *>>
+abstract_expressionist::dissect_as_column_equality() const {
+    return boost::none;
+}
+
+optional<std::pair<const column_mapper *, const query_base *>>
+abstract_expressionist::dissect_as_subquery_test() const {
+    return boost::none;
+}
+
+bool
+abstract_expressionist::might_aggregate() const {
+    return true;
+}
+
 vector<const abstract_mapper_base *>
 abstract_expressionist::own_all(vector<unique_ptr<const abstract_mapper_base>> &&v) {
     return transform(
@@ -30,6 +55,47 @@ abstract_expressionist::own_all(vector<unique_ptr<const abstract_mapper_base>> &
     );
 }
 
+unique_ptr<const abstract_expressionist>
+make_filter_expressionist(const abstract_mapper_base &aggregate, const abstract_mapper<bool> &predicate) {
+    struct expressionist : public abstract_expressionist {
+        const abstract_mapper_base &_aggregate;
+        const abstract_mapper<bool> &_predicate;
+
+        expressionist(const abstract_mapper_base &aggregate, const abstract_mapper<bool> &predicate) :
+            _aggregate(own(clone(aggregate))),
+            _predicate(own(clone(predicate)))
+        {}
+
+        virtual void
+        write_expression(sql &cmd) const override {
+            sql::filter_scope filter(cmd, _predicate.only_column());
+            cmd.write_evaluation(_aggregate.only_column());
+            if (! filter.is_used())  throw filter_exception();
+        }
+
+        virtual column_id_set
+        imports() const override {
+            column_id_set result = _aggregate.imports();
+            add_to_set(result, _predicate.imports());
+            return result;
+        }
+    };
+
+    return quince::make_unique<expressionist>(aggregate, predicate);
+}
+
+
+bool
+might_aggregate(const abstract_mapper_base &mapper) {
+    bool result = false;
+    mapper.for_each_column([&](const column_mapper &c) {
+        if (const exprn_mapper_base * const exprn = dynamic_cast<const exprn_mapper_base *>(&c))
+            if (exprn->might_aggregate())
+                result = true;
+    });
+    return result;
+}
+
 
 exprn_mapper_base::~exprn_mapper_base()
 {}
@@ -45,6 +111,31 @@ exprn_mapper_base::imports() const {
     return set_union<column_id>(_expressionist->imports(), { id() });
 }
 
+const vector<const abstract_mapper_base *> *
+exprn_mapper_base::dissect_as_junction(const string &op) const {
+    return _expressionist->dissect_as_junction(op);
+}
+
+optional<std::pair<const column_mapper *, cell>>
+exprn_mapper_base::dissect_as_value_equality(const database &db) const {
+    return _expressionist->dissect_as_value_equality(db);
+}
+
+optional<std::pair<const column_mapper *, const column_mapper *>>
+exprn_mapper_base::dissect_as_column_equality() const {
+    return _expressionist->dissect_as_column_equality();
+}
+
+optional<std::pair<const column_mapper *, const query_base *>>
+exprn_mapper_base::dissect_as_subquery_test() const {
+    return _expressionist->dissect_as_subquery_test();
+}
+
+bool
+exprn_mapper_base::might_aggregate() const {
+    return _expressionist->might_aggregate();
+}
+
 exprn_mapper_base::exprn_mapper_base(unique_ptr<const abstract_expressionist> e) :
     abstract_mapper_base(boost::none),
     column_mapper(boost::none),
@@ -74,6 +165,37 @@ exprn_mapper_base::make_delegating_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_evaluation(_delegate.only_column()); }
         virtual column_id_set imports() const override          { return _delegate.imports(); }
+        virtual bool might_aggregate() const override           { return quince::might_aggregate(_delegate); }
+
+        // A wrapped expression can be dissected just as well as the original.
+        //
+        const exprn_mapper_base *exprn_delegate() const {
+            return dynamic_cast<const exprn_mapper_base *>(&_delegate);
+        }
+
+        virtual const vector<const abstract_mapper_base *> *
+        dissect_as_junction(const string &op) const override {
+            const exprn_mapper_base * const d = exprn_delegate();
+            return d ? d->dissect_as_junction(op) : nullptr;
+        }
+
+        virtual optional<std::pair<const column_mapper *, cell>>
+        dissect_as_value_equality(const database &db) const override {
+            const exprn_mapper_base * const d = exprn_delegate();
+            return d ? d->dissect_as_value_equality(db) : boost::none;
+        }
+
+        virtual optional<std::pair<const column_mapper *, const column_mapper *>>
+        dissect_as_column_equality() const override {
+            const exprn_mapper_base * const d = exprn_delegate();
+            return d ? d->dissect_as_column_equality() : boost::none;
+        }
+
+        virtual optional<std::pair<const column_mapper *, const query_base *>>
+        dissect_as_subquery_test() const override {
+            const exprn_mapper_base * const d = exprn_delegate();
+            return d ? d->dissect_as_subquery_test() : boost::none;
+        }
     };
 
     return quince::make_unique<expressionist>(delegate);
@@ -52,4 +52,54 @@ make_function_call_expressionist(
     return quince::make_unique<expressionist>(function_name, std::move(args));
 }
 
+unique_ptr<const abstract_expressionist>
+make_aggregate_call_expressionist(
+    const string &function_name,
+    vector<unique_ptr<const abstract_mapper_base>> &&args,
+    bool distinct,
+    unique_ptr<const abstract_mapper_base> ordered_by)
+{
+    struct expressionist : public abstract_expressionist {
+        const string _function_name;
+        const vector<const abstract_mapper_base *> _args;
+        const bool _distinct;
+        const abstract_mapper_base * const _ordered_by;
+
+        expressionist(
+            const string &function_name,
+            vector<unique_ptr<const abstract_mapper_base>> &&args,
+            bool distinct,
+            unique_ptr<const abstract_mapper_base> &ordered_by
+        ) :
+#ifdef __clang__
+            _function_name(function_name.c_str()),
+#else
+            _function_name(function_name),
+#endif
+            _args(own_all(std::move(args))),
+            _distinct(distinct),
+            _ordered_by(own_or_null(ordered_by))
+        {}
+
+        virtual void
+        write_expression(sql &cmd) const override {
+            cmd.write_aggregate_call(
+                _function_name,
+                transform(_args, [](const abstract_mapper_base *m)  { return &m->only_column();} ),
+                _distinct,
+                _ordered_by ? &_ordered_by->only_column() : nullptr
+            );
+        }
+
+        virtual column_id_set
+        imports() const override {
+            column_id_set result;
+            for (const auto a: _args)  add_to_set(result, a->imports());
+            if (_ordered_by)  add_to_set(result, _ordered_by->imports());
+            return result;
+        }
+    };
+
+    return quince::make_unique<expressionist>(function_name, std::move(args), distinct, ordered_by);
+}
 }
@@ -26,13 +26,32 @@ namespace {
 	template<typename T>
 	exprn_mapper<optional<double>>
 	generic_avg(const abstract_mapper<T> &arg) {
-		return cast<optional<double>>(function<any_avg>("avg", arg));
+		return cast<optional<double>>(aggregate<any_avg>("avg", arg));
 	}
 
+    // Likewise for the other statistics, which the server computes in the same type as avg.
+    //
+    template<typename T>
+    exprn_mapper<optional<double>>
+    generic_statistic(const string &function_name, const abstract_mapper<T> &arg) {
+        return cast<optional<double>>(aggregate<any_avg>(function_name, arg));
+    }
+
+    template<typename T>
+    exprn_mapper<optional<double>>
+    generic_percentile_cont(double fraction, const abstract_mapper<T> &arg) {
+        return cast<optional<double>>(exprn_mapper<any_avg>(make_aggregate_call_expressionist(
+            "percentile_cont",
+            make_new_mappers(fraction),
+            false,
+            clone(arg)
+        )));
+    }
+
     template<typename Return, typename Arg>
     exprn_mapper<Return>
     generic_sum(const abstract_mapper<Arg> &arg) {
-        return cast<optional<Return>>(function<any_sum>("sum", arg)).get_value_or(0);
+        return cast<optional<Return>>(aggregate<any_sum>("sum", arg)).get_value_or(0);
     }
 }
 
@@ -51,7 +70,38 @@ exprn_mapper<optional<double>>  avg(const abstract_mapper<int64_t> &arg)    { re
 exprn_mapper<optional<double>>  avg(const abstract_mapper<float> &arg)      { return generic_avg(arg); }
 exprn_mapper<optional<double>>  avg(const abstract_mapper<double> &arg)     { return generic_avg(arg); }
 
-exprn_mapper<int64_t>   count(const abstract_mapper_base &arg)      { return function<int64_t>("count", arg ); }
+exprn_mapper<int64_t>   count(const abstract_mapper_base &arg)      { return aggregate<int64_t>("count", arg); }
+
+exprn_mapper<int64_t>
+count_distinct(const abstract_mapper_base &arg) {
+    return exprn_mapper<int64_t>(make_aggregate_call_expressionist("count", make_new_mappers(arg), true));
+}
+
+exprn_mapper<optional<double>>  stddev(const abstract_mapper<int16_t> &arg)     { return generic_statistic("stddev", arg); }
+exprn_mapper<optional<double>>  stddev(const abstract_mapper<int32_t> &arg)     { return generic_statistic("stddev", arg); }
+exprn_mapper<optional<double>>  stddev(const abstract_mapper<int64_t> &arg)     { return generic_statistic("stddev", arg); }
+exprn_mapper<optional<double>>  stddev(const abstract_mapper<float> &arg)       { return generic_statistic("stddev", arg); }
+exprn_mapper<optional<double>>  stddev(const abstract_mapper<double> &arg)      { return generic_statistic("stddev", arg); }
+
+exprn_mapper<optional<double>>  variance(const abstract_mapper<int16_t> &arg)   { return generic_statistic("variance", arg); }
+exprn_mapper<optional<double>>  variance(const abstract_mapper<int32_t> &arg)   { return generic_statistic("variance", arg); }
+exprn_mapper<optional<double>>  variance(const abstract_mapper<int64_t> &arg)   { return generic_statistic("variance", arg); }
+exprn_mapper<optional<double>>  variance(const abstract_mapper<float> &arg)     { return generic_statistic("variance", arg); }
+exprn_mapper<optional<double>>  variance(const abstract_mapper<double> &arg)    { return generic_statistic("variance", arg); }
+
+exprn_mapper<optional<double>>  percentile_cont(double f, const abstract_mapper<int16_t> &arg)  { return generic_percentile_cont(f, arg); }
+exprn_mapper<optional<double>>  percentile_cont(double f, const abstract_mapper<int32_t> &arg)  { return generic_percentile_cont(f, arg); }
+exprn_mapper<optional<double>>  percentile_cont(double f, const abstract_mapper<int64_t> &arg)  { return generic_percentile_cont(f, arg); }
+exprn_mapper<optional<double>>  percentile_cont(double f, const abstract_mapper<float> &arg)    { return generic_percentile_cont(f, arg); }
+exprn_mapper<optional<double>>  percentile_cont(double f, const abstract_mapper<double> &arg)   { return generic_percentile_cont(f, arg); }
+
+exprn_mapper<optional<bool>>    bool_and(const abstract_mapper<bool> &arg)  { return aggregate<optional<bool>>("bool_and", arg); }
+exprn_mapper<optional<bool>>    bool_or(const abstract_mapper<bool> &arg)   { return aggregate<optional<bool>>("bool_or", arg); }
+
+exprn_mapper<optional<string>>
+string_agg(const abstract_mapper<string> &arg, const string &delimiter) {
+    return aggregate<optional<string>>("string_agg", arg, delimiter);
+}
 
 exprn_mapper<int64_t>   sum(const abstract_mapper<int16_t> &arg)    { return generic_sum<int64_t>(arg); }
 exprn_mapper<int64_t>   sum(const abstract_mapper<int32_t> &arg)    { return generic_sum<int64_t>(arg); }
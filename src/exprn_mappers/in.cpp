@@ -71,6 +71,11 @@ make_in_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_in(_lhs.only_column(), _rhs); }
         virtual column_id_set imports() const override          { return set_union(_lhs.imports(), _rhs.imports()); }
+
+        virtual boost::optional<std::pair<const column_mapper *, const query_base *>>
+        dissect_as_subquery_test() const override {
+            return std::make_pair(&_lhs.only_column(), &_rhs);
+        }
     };
 
     return quince::make_unique<expressionist>(lhs, rhs);
@@ -41,6 +41,11 @@ make_infix_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_infix_exprn(_lhs.only_column(), _op, _rhs.only_column()); }
         virtual column_id_set imports() const override          { return set_union(_lhs.imports(), _rhs.imports()); }
+
+        virtual bool
+        might_aggregate() const override {
+            return quince::might_aggregate(_lhs) || quince::might_aggregate(_rhs);
+        }
     };
 
     return quince::make_unique<expressionist>(op, lhs, rhs);
@@ -8,6 +8,7 @@
 #include <quince/query.h>
 
 using std::unique_ptr;
+using std::vector;
 
 
 namespace quince {
@@ -35,9 +36,58 @@ make_intrinsic_comparison_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_intrinsic_comparison(_relation, _lhs, _rhs); }
         virtual column_id_set imports() const override          { return set_union(_lhs.imports(), _rhs.imports()); }
+
+        virtual bool
+        might_aggregate() const override {
+            return quince::might_aggregate(_lhs) || quince::might_aggregate(_rhs);
+        }
+
+        virtual boost::optional<std::pair<const column_mapper *, const column_mapper *>>
+        dissect_as_column_equality() const override {
+            if (_relation != relation::equal  ||  _lhs.size() != 1  ||  _rhs.size() != 1)  return boost::none;
+
+            return std::make_pair(&_lhs.only_column(), &_rhs.only_column());
+        }
     };
 
     return quince::make_unique<expressionist>(r, lhs, rhs);
 }
 
+unique_ptr<const abstract_expressionist>
+make_keyset_comparison_expressionist(
+    vector<unique_ptr<const abstract_mapper_base>> &&orders_hi_to_lo,
+    const vector<cell> &key,
+    bool after
+) {
+    struct expressionist : public abstract_expressionist {
+        const vector<const abstract_mapper_base *> _orders_hi_to_lo;
+        const vector<cell> _key;
+        const bool _after;
+
+        expressionist(
+            vector<unique_ptr<const abstract_mapper_base>> &&orders_hi_to_lo,
+            const vector<cell> &key,
+            bool after
+        ) :
+            _orders_hi_to_lo(own_all(std::move(orders_hi_to_lo))),
+            _key(key),
+            _after(after)
+        {}
+
+        virtual void
+        write_expression(sql &cmd) const override {
+            cmd.write_keyset_comparison(_orders_hi_to_lo, _key, _after);
+        }
+
+        virtual column_id_set
+        imports() const override {
+            column_id_set result;
+            for (const auto o: _orders_hi_to_lo)  add_to_set(result, o->imports());
+            return result;
+        }
+    };
+
+    return quince::make_unique<expressionist>(std::move(orders_hi_to_lo), key, after);
+}
+
 }
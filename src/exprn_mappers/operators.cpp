@@ -9,6 +9,9 @@
 #include <quince/query.h>
 
 using boost::optional;
+using std::string;
+using std::unique_ptr;
+using std::vector;
 
 
 namespace quince {
@@ -21,6 +24,62 @@ namespace {
         else
             return predicate(ap);
     }
+
+    // Append clones of the operands that p contributes to a junction with logical operator op:
+    // i.e. p's own operands if p is a junction with the same op, otherwise p itself.
+    // That way a chain of ANDs (or of ORs) becomes a single flat junction.
+    //
+    void
+    add_junction_operands(
+        const string &op,
+        const abstract_predicate &p,
+        vector<unique_ptr<const abstract_mapper_base>> &operands
+    ) {
+        const auto * const exprn = dynamic_cast<const exprn_mapper_base *>(&p);
+        if (const vector<const abstract_mapper_base *> * const parts = exprn ? exprn->dissect_as_junction(op) : nullptr)
+            for (const abstract_mapper_base *part: *parts)
+                operands.push_back(clone(*part));
+        else
+            operands.push_back(clone(p));
+    }
+
+    predicate
+    make_junction(const string &op, const abstract_predicate &lhs, const abstract_predicate &rhs) {
+        struct expressionist : public abstract_expressionist {
+            const string _op;
+            const vector<const abstract_mapper_base *> _operands;
+
+            expressionist(const string &op, vector<unique_ptr<const abstract_mapper_base>> &&operands) :
+                _op(op),
+                _operands(own_all(std::move(operands)))
+            {}
+
+            virtual void write_expression(sql &cmd) const override  { cmd.write_junction(_op, _operands); }
+
+            virtual column_id_set
+            imports() const override {
+                column_id_set result;
+                for (const auto o: _operands)  add_to_set(result, o->imports());
+                return result;
+            }
+
+            virtual const vector<const abstract_mapper_base *> *
+            dissect_as_junction(const string &op) const override {
+                return op == _op ? &_operands : nullptr;
+            }
+
+            virtual bool
+            might_aggregate() const override {
+                for (const auto o: _operands)  if (quince::might_aggregate(*o))  return true;
+                return false;
+            }
+        };
+
+        vector<unique_ptr<const abstract_mapper_base>> operands;
+        add_junction_operands(op, lhs, operands);
+        add_junction_operands(op, rhs, operands);
+        return predicate(quince::make_unique<expressionist>(op, std::move(operands)));
+    }
 }
 
 predicate
@@ -30,7 +89,7 @@ operator&&(const abstract_predicate &lhs, const abstract_predicate &rhs) {
         a_priori_true(rhs) ?    make_concrete(lhs) :
         a_priori_false(lhs) ?   predicate(false) :
         a_priori_false(rhs) ?   predicate(false) :
-                                predicate(make_infix_expressionist(" AND ", clone(lhs), clone(rhs)));
+                                make_junction(sql::and_operator, lhs, rhs);
 }
 
 predicate
@@ -40,7 +99,7 @@ operator||(const abstract_predicate &lhs, const abstract_predicate &rhs) {
         a_priori_false(rhs) ?   make_concrete(lhs) :
         a_priori_true(lhs) ?    predicate(true) :
         a_priori_true(rhs) ?    predicate(true) :
-                                predicate(make_infix_expressionist(" OR ", clone(lhs), clone(rhs)));
+                                make_junction(sql::or_operator, lhs, rhs);
 }
 
 predicate
@@ -0,0 +1,40 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <quince/detail/sql.h>
+#include <quince/detail/util.h>
+#include <quince/exprn_mappers/param.h>
+#include <quince/query.h>
+
+using std::unique_ptr;
+
+
+namespace quince {
+
+unique_ptr<const abstract_expressionist>
+make_parameter_expressionist(sql::parameter_id id) {
+    struct expressionist : public abstract_expressionist {
+        const sql::parameter_id _id;
+
+        explicit expressionist(sql::parameter_id id) : _id(id)  {}
+        virtual void write_expression(sql &cmd) const override  { cmd.write_parameter(_id); }
+        virtual column_id_set imports() const override          { return {}; }
+        virtual bool might_aggregate() const override           { return false; }
+    };
+
+    return quince::make_unique<expressionist>(id);
+}
+
+namespace {
+    std::atomic<sql::parameter_id> counter(0);
+}
+
+sql::parameter_id
+next_parameter_id() {
+    return ++counter;
+}
+
+}
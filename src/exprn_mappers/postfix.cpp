@@ -34,6 +34,7 @@ make_postfix_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_postfix_exprn(_operand.only_column(), _op); }
         virtual column_id_set imports() const override          { return _operand.imports(); }
+        virtual bool might_aggregate() const override           { return quince::might_aggregate(_operand); }
     };
 
     return quince::make_unique<expressionist>(op, operand);
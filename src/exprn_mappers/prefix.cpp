@@ -35,6 +35,7 @@ make_prefix_expressionist(
 
         virtual void write_expression(sql &cmd) const override  { cmd.write_prefix_exprn(_op, _operand.only_column()); }
         virtual column_id_set imports() const override          { return _operand.imports(); }
+        virtual bool might_aggregate() const override           { return quince::might_aggregate(_operand); }
 
         virtual optional<std::pair<const abstract_mapper_base *, bool>>
         dissect_as_order_specification() const override {
@@ -0,0 +1,57 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <quince/detail/sql.h>
+#include <quince/detail/util.h>
+#include <quince/exprn_mappers/window.h>
+#include <quince/query.h>
+
+using std::shared_ptr;
+using std::unique_ptr;
+
+
+namespace quince {
+
+const frame_bound unbounded_preceding   { frame_bound::kind::unbounded_preceding, 0 };
+const frame_bound current_row           { frame_bound::kind::current_row, 0 };
+const frame_bound unbounded_following   { frame_bound::kind::unbounded_following, 0 };
+
+frame_bound preceding(uint32_t offset)  { return { frame_bound::kind::preceding, offset }; }
+frame_bound following(uint32_t offset)  { return { frame_bound::kind::following, offset }; }
+
+exprn_mapper<int64_t>   row_number()    { return aggregate<int64_t>("row_number", {}); }
+exprn_mapper<int64_t>   rank()          { return aggregate<int64_t>("rank", {}); }
+exprn_mapper<int64_t>   dense_rank()    { return aggregate<int64_t>("dense_rank", {}); }
+
+
+unique_ptr<const abstract_expressionist>
+make_window_expressionist(shared_ptr<const window_definition> definition) {
+    struct expressionist : public abstract_expressionist {
+        const shared_ptr<const window_definition> _definition;
+
+        explicit expressionist(const shared_ptr<const window_definition> &definition) :
+            _definition(definition)
+        {}
+
+        virtual void
+        write_expression(sql &cmd) const override {
+            sql::window_scope window(cmd, *_definition);
+            cmd.write_evaluation(_definition->_windowed->only_column());
+            if (! window.is_used())  throw window_exception();
+        }
+
+        virtual column_id_set
+        imports() const override {
+            column_id_set result = _definition->_windowed->imports();
+            for (const auto &p: _definition->_partitions)  add_to_set(result, p->imports());
+            for (const auto &o: _definition->_orders)  add_to_set(result, o->imports());
+            return result;
+        }
+    };
+
+    return quince::make_unique<expressionist>(definition);
+}
+
+}
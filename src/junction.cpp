@@ -4,11 +4,15 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <assert.h>
+#include <quince/database.h>
+#include <quince/exceptions.h>
 #include <quince/detail/junction.h>
 #include <quince/detail/sql.h>
+#include <quince/detail/table_base.h>
 #include <quince/query.h>
 
 using std::unique_ptr;
+using std::vector;
 
 
 namespace quince {
@@ -63,8 +67,18 @@ junction_base::adopt(unique_ptr<abstract_query_base> query) {
 
 void
 conditional_junction_base::write_table_reference(sql &cmd) const {
-    cmd.write_qualified_join(lhs(), rhs(), _type);
-
+    if (_is_lateral) {
+        cmd.write_lateral_join(lhs(), rhs(), _type);
+        return;
+    }
+    if (is_eliminable(cmd)) {
+        lhs().write_table_reference(cmd);
+        return;
+    }
+    {
+        sql::additional_referenced_columns_scope referenced(cmd, _predicate.imports());
+        cmd.write_qualified_join(lhs(), rhs(), _type);
+    }
     sql::aliased_columns_scope aliases(cmd, aliased_columns());
     cmd.write_on(_predicate);
 }
@@ -80,4 +94,44 @@ conditional_junction_base::a_priori_empty() const {
     }
 }
 
-}
\ No newline at end of file
+void
+conditional_junction_base::check_lateral_support(const abstract_query_base &lhs) {
+    if (! lhs.get_database().supports_lateral_join())  throw unsupported_exception();
+}
+
+bool
+conditional_junction_base::is_eliminable(const sql &cmd) const {
+    if (_type != conditional_junction_type::left  ||  _is_lateral)  return false;
+
+    const table_base * const table = dynamic_cast<const table_base *>(&rhs());
+    if (table == nullptr  ||  ! table->has_key())  return false;
+
+    const column_id_set rhs_ids = rhs().exports().column_ids();
+    for (const column_id id: rhs_ids)  if (cmd.column_is_referenced(id))  return false;
+
+    column_id_set unmatched_key_ids = table->get_key_mapper_base().column_ids();
+    if (! is_subset(unmatched_key_ids, rhs_ids))  return false;
+
+    // Conjuncts of _predicate other than key equalities can only turn matches into
+    // non-matches, so they don't matter: each lhs() row still yields exactly one output row.
+    //
+    const auto * const exprn = dynamic_cast<const exprn_mapper_base *>(&_predicate);
+    if (exprn == nullptr)  return false;
+    const vector<const abstract_mapper_base *> * const parts = exprn->dissect_as_junction(sql::and_operator);
+    const vector<const abstract_mapper_base *> conjuncts = parts ? *parts : vector<const abstract_mapper_base *>{exprn};
+
+    for (const abstract_mapper_base *c: conjuncts)
+        if (const auto * const conjunct = dynamic_cast<const exprn_mapper_base *>(c))
+            if (const auto equality = conjunct->dissect_as_column_equality()) {
+                const column_mapper &a = *equality->first;
+                const column_mapper &b = *equality->second;
+                if (unmatched_key_ids.count(a.id())  &&  ! intersects(b.imports(), rhs_ids))
+                    unmatched_key_ids.erase(a.id());
+                else if (unmatched_key_ids.count(b.id())  &&  ! intersects(a.imports(), rhs_ids))
+                    unmatched_key_ids.erase(b.id());
+            }
+
+    return unmatched_key_ids.empty();
+}
+
+}
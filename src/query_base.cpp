@@ -40,6 +40,19 @@ struct query_base::combination {
 };
 
 
+struct query_base::semi_join {
+    const query_base &_subquery;
+    std::vector<std::pair<const column_mapper *, const column_mapper *>> _outer_inner_pairs;
+    predicate _local_predicate;
+};
+
+
+struct query_base::statement_cache {
+    std::mutex _mutex;
+    unique_ptr<const sql> _sql;
+};
+
+
 query_base::~query_base()
 {}
 
@@ -47,14 +60,12 @@ unique_ptr<row>
 query_base::fetch_row(const session &s) const {
     assert (! a_priori_empty());  // Failure means we haven't optimized well.
 
-    const unique_ptr<sql> cmd = get_database().make_sql();
-    write_maximal_select(*cmd);
-    return s->exec_with_one_output(*cmd);
+    return s->exec_with_one_output(*make_bound_select());
 }
 
 void
 query_base::write_table_reference(sql &cmd) const {
-    cmd.write("(");
+    cmd.write('(');
     {
         sql::nested_select_scope nested(cmd);
         write_select(cmd);
@@ -73,22 +84,22 @@ query_base::a_priori_empty() const {
     return a_priori_false(_predicate) || _from.a_priori_empty();
 }
 
-void
+optional<uint64_t>
 query_base::remove() {
     const table_base &t = table();
-    t.remove_where(predicate_applicable_to(t));
+    return t.remove_where(predicate_applicable_to(t), _bindings);
 }
 
 void
 query_base::remove_existing() {
     const table_base &t = table();
-    t.remove_existing_where(predicate_applicable_to(t));
+    t.remove_existing_where(predicate_applicable_to(t), _bindings);
 }
 
 bool
 query_base::remove_if_exists() {
     const table_base &t = table();
-    return t.remove_if_exists_where(predicate_applicable_to(t));
+    return t.remove_if_exists_where(predicate_applicable_to(t), _bindings);
 }
 
 const database &
@@ -112,7 +123,52 @@ query_base::might_have_duplicate_rows() const {
 }
 
 void
-query_base::write_select(sql &cmd) const {
+query_base::write_select(sql &cmd, bool existence_test) const {
+    cmd.add_parameter_bindings(_bindings);
+
+    // Any subqueries at the head of the FROM chain that merely filter and/or project
+    // their own FROM (see is_mergeable_subquery()) are merged into this SELECT: their
+    // predicates are added to ours, and their exported columns are written as expressions
+    // rather than as aliases.  So e.g. q.select(...).where(...) doesn't generate a
+    // "(SELECT ...) AS q$n" layer.
+    //
+    const abstract_query_base *from = &_from;
+    predicate pred = _predicate;
+    column_id_set from_imports = additional_imports();
+    column_id_set referenced = imports();  // see below
+    while (const query_base * const inner = dynamic_cast<const query_base *>(from)) {
+        if (! inner->is_mergeable_subquery())  break;
+
+        cmd.add_parameter_bindings(inner->_bindings);
+        pred = inner->_predicate && pred;
+        add_to_set(from_imports, inner->additional_imports());
+        add_to_set(from_imports, inner->imports());
+        if (! inner->value_mapper_is_inherited())  add_to_set(referenced, inner->imports());
+        from = &inner->_from;
+    }
+
+    // If decorrelate() was called, then each exists() or in(..., subquery) conjunct of the
+    // predicate that qualifies (see find_semi_join()) becomes a join with a derived table,
+    // which the DBMS evaluates once, rather than once per row.
+    //
+    vector<semi_join> semi_joins;
+    if (_decorrelate  &&  ! a_priori_true(pred)) {
+        const column_id_set outer_ids = from->exports().column_ids();
+        const auto * const exprn = dynamic_cast<const exprn_mapper_base *>(&pred);
+        const vector<const abstract_mapper_base *> * const parts = exprn ? exprn->dissect_as_junction(sql::and_operator) : nullptr;
+        const vector<const abstract_mapper_base *> conjuncts = parts ? *parts : vector<const abstract_mapper_base *>{&pred};
+
+        predicate remainder(true);
+        for (const abstract_mapper_base *c: conjuncts) {
+            const abstract_predicate &conjunct = dynamic_cast<const abstract_predicate &>(*c);
+            if (const optional<semi_join> sj = find_semi_join(conjunct, outer_ids))
+                semi_joins.push_back(*sj);
+            else
+                remainder = remainder && conjunct;
+        }
+        pred = remainder;
+    }
+
     size_t paren_depth = 0;
     if (_database.imposes_combination_precedence()) {
         // If the following assertion fails, we've added a new database class that imposes
@@ -122,41 +178,65 @@ query_base::write_select(sql &cmd) const {
         //
         assert(_database.supports_nested_combinations());
         for (; paren_depth+1 < _combinations.size(); paren_depth++)
-            cmd.write("(");
+            cmd.write('(');
     }
     {
-        sql::additional_aliased_columns_scope aliases1(cmd, _from.aliased_columns());
+        sql::additional_aliased_columns_scope aliases1(cmd, from->aliased_columns());
         cmd.write("SELECT ");
-        if (_distinct_list) {
+        if (_distinct_list  &&  ! existence_test) {
             sql::additional_aliased_columns_scope aliases2(cmd, get_value_mapper_base().column_ids());
             cmd.write_distinct(*_distinct_list);
         }
-        cmd.write_select_list(get_value_mapper_base());
+        if (! _value_mapper_is_inherited  &&  _group_by.empty()  &&  might_aggregate(get_value_mapper_base())) {
+            // An aggregate makes one row even if the WHERE clause matches none, so it must
+            // be written even if none of its columns are wanted (when the select list would
+            // otherwise be "1", which makes no rows).
+            //
+            sql::wanted_aliases_scope all_wanted(cmd, universalizable_column_id_set::universal());
+            cmd.write_select_list(get_value_mapper_base());
+        }
+        else
+            cmd.write_select_list(get_value_mapper_base());
     }
+    // Every column that this SELECT mentions outside its FROM clause, so that a left-joined
+    // table that contributes none of them can be left out (see conditional_junction_base).
+    //
+    add_to_set(referenced, pred.imports());
+    for (const auto &o: all_orders_hi_to_lo())
+        add_to_set(referenced, o->imports());
+    for (const abstract_mapper_base *g: _group_by)
+        add_to_set(referenced, g->imports());
+    for (const semi_join &sj: semi_joins)
+        for (const auto &p: sj._outer_inner_pairs)
+            add_to_set(referenced, p.first->imports());
+
     {
-        sql::additional_wanted_aliases_scope during_from(cmd, additional_imports());
+        sql::additional_wanted_aliases_scope during_from(cmd, from_imports);
+        sql::referenced_columns_scope during_from_too(cmd, referenced);
         cmd.write(" FROM ");
-        _from.write_table_reference(cmd);
+        from->write_table_reference(cmd);
+        for (const semi_join &sj: semi_joins)
+            write_semi_join(cmd, sj, *from);
     }
 
     sql::marker_t site_for_combinations;
     {
-        sql::additional_aliased_columns_scope aliases1(cmd, _from.aliased_columns());
+        sql::additional_aliased_columns_scope aliases1(cmd, from->aliased_columns());
 
-        if (! a_priori_true(_predicate)) {
+        if (! a_priori_true(pred)) {
             sql::wanted_aliases_scope during_where(cmd, universalizable_column_id_set::universal());
-            cmd.write_where(_predicate);
+            cmd.write_where(pred);
         }
 
        sql::additional_aliased_columns_scope aliases2(cmd, exports().column_ids());
 
-        if (!_group_by.empty())  cmd.write_group_by(_group_by);
+        if (!_group_by.empty())  cmd.write_group_by(_group_by, _grouping_type, _grouping_sets);
 
         site_for_combinations = cmd.here();
 
         if (! a_priori_empty()) {
             const vector<const abstract_mapper_base *> orders = all_orders_hi_to_lo();
-            if (!orders.empty()) {
+            if (!orders.empty()  &&  ! existence_test) {
                 sql::wanted_aliases_scope during_order(cmd, universalizable_column_id_set::universal());
                 cmd.write_ordered_by(orders);
             }
@@ -166,13 +246,14 @@ query_base::write_select(sql &cmd) const {
                 cmd.write_offset(_offset);
             }
         }
+        if (_row_lock)  cmd.write_row_lock(*_row_lock, _row_lock_wait);
     }
 
     if (! _combinations.empty()) {
         sql::text_insertion_scope insertion(cmd, site_for_combinations);
         for (const auto c: _combinations) {
             if (paren_depth > 0) {
-                cmd.write(")");
+                cmd.write(')');
                 paren_depth--;
             }
             cmd.write_combination(c->_type, c->_all, *c->_rhs);
@@ -183,14 +264,74 @@ query_base::write_select(sql &cmd) const {
 void
 query_base::write_maximal_select(sql &cmd) const {
     sql::wanted_aliases_scope(cmd, imports());
+    const optional<sql::marker_t> with_site = cmd.begin_with_clause();
     write_select(cmd);
+    if (with_site)  cmd.end_with_clause(*with_site);
+}
+
+void
+query_base::write_existence_select(sql &cmd) const {
+    // Orders matter when there's an offset, and the select list matters to combinations
+    // (which must have matching columns), to group_by (which may refer to it), and if it
+    // aggregates (which makes one row even if the WHERE clause matches none).
+    //
+    if (   _offset != 0
+        || ! _combinations.empty()
+        || ! _group_by.empty()
+        || (! _value_mapper_is_inherited  &&  might_aggregate(get_value_mapper_base()))
+       ) {
+        write_maximal_select(cmd);
+        return;
+    }
+    sql::wanted_aliases_scope nothing_wanted(cmd, column_id_set());
+    const optional<sql::marker_t> with_site = cmd.begin_with_clause();
+    write_select(cmd, true);
+    if (with_site)  cmd.end_with_clause(*with_site);
 }
 
 std::string
 query_base::to_string() const {
-    const unique_ptr<sql> cmd = _database.make_sql();
-    write_maximal_select(*cmd);
-    return cmd->get_text();
+    return make_maximal_select()->get_text();
+}
+
+unique_ptr<sql>
+query_base::make_maximal_select() const {
+    unique_ptr<sql> cmd;
+    {
+        std::lock_guard<std::mutex> lock(_statement_cache->_mutex);
+        if (_statement_cache->_sql)
+            cmd = clone(*_statement_cache->_sql);
+    }
+    if (! cmd) {
+        cmd = _database.make_sql();
+        cmd->reserve(*_text_size_hint);
+        write_maximal_select(*cmd);
+        *_text_size_hint = cmd->get_text().size();
+
+        if (cmd->has_parameters()) {
+            // The copies that share the cache may bind different values, or none, to
+            // the params that this query binds.
+            //
+            unique_ptr<sql> cached = clone(*cmd);
+            cached->forget_parameter_bindings(_bindings);
+
+            std::lock_guard<std::mutex> lock(_statement_cache->_mutex);
+            _statement_cache->_sql = std::move(cached);
+        }
+    }
+    return cmd;
+}
+
+unique_ptr<sql>
+query_base::make_bound_select() const {
+    unique_ptr<sql> cmd = make_maximal_select();
+    cmd->bind_parameters(_bindings);
+    return cmd;
+}
+
+void
+query_base::discard_statement_cache() {
+    _statement_cache = std::make_shared<statement_cache>();
 }
 
 query_base::query_base(const abstract_query_base &from) :
@@ -199,24 +340,37 @@ query_base::query_base(const abstract_query_base &from) :
     _database(_from.get_database()),
     _value_mapper_is_inherited(true),
     _predicate(true),
+    _grouping_type(grouping_type::plain),
     _offset(0),
-    _fetch_size(100)
-{}
+    _fetch_size(100),
+    _decorrelate(false),
+    _row_lock_wait(row_lock_wait::wait),
+    _text_size_hint(std::make_shared<std::atomic<size_t>>(0)),
+    _statement_cache(std::make_shared<statement_cache>())
+{
+    // Params inside from are still bound by its bindings (unless this query rebinds them).
+    //
+    if (const query_base * const from_query = dynamic_cast<const query_base *>(&_from))
+        _bindings = from_query->_bindings;
+}
 
 void
 query_base::add_constraint(const abstract_predicate &pred) {
+    discard_statement_cache();
     assert(is_predicational());
     _predicate = _predicate && pred;
 }
 
 void
 query_base::add_distinct() {
+    discard_statement_cache();
     assert(! _distinct_list);
     _distinct_list = vector<const abstract_mapper_base*>();
 }
 
 void
 query_base::add_distinct_on(vector<unique_ptr<const abstract_mapper_base>> &&distincts) {
+    discard_statement_cache();
     assert(_distinct_list);
     for (auto &distinct: distincts)
         _distinct_list->push_back(&own(distinct));
@@ -229,6 +383,7 @@ query_base::distinct_list() const {
 
 void
 query_base::add_orders(vector<unique_ptr<const abstract_mapper_base>> &&orders_hi_to_lo) {
+    discard_statement_cache();
     BOOST_REVERSE_FOREACH(auto &order, orders_hi_to_lo)
         _orders_lo_to_hi.push_back(&own(order));
 }
@@ -239,17 +394,20 @@ query_base::clear_orders() {
     // numerous if you made repeated calls to add_orders/clear_orders; but these are
     // protected functions and I trust the caller.
 
+    discard_statement_cache();
     _orders_lo_to_hi.clear();
 }
 
 void
 query_base::set_limit(uint32_t n_rows) {
+    discard_statement_cache();
     if (!_limit || n_rows <= _limit)
         _limit = n_rows;
 }
 
 void
 query_base::set_skip(uint32_t n_rows) {
+    discard_statement_cache();
     _offset += n_rows;
 
     if (! _limit)
@@ -266,11 +424,18 @@ query_base::set_fetch_size(uint32_t n_rows) {
 }
 
 void
-query_base::set_group_by(vector<unique_ptr<const abstract_mapper_base>> &&group_by) {
+query_base::set_group_by(
+    vector<unique_ptr<const abstract_mapper_base>> &&group_by,
+    grouping_type type,
+    const vector<vector<size_t>> &grouping_sets
+) {
+    discard_statement_cache();
     // TODO: refactor so I can use the code currently in abstract_expressionist::own_all().
 
     for (auto &g: group_by)
         _group_by.push_back(&own(g));
+    _grouping_type = type;
+    _grouping_sets = grouping_sets;
 }
 
 bool
@@ -290,6 +455,7 @@ query_base::allow_fake_combine_with(const query_base &rhs) const {
 
 void
 query_base::add_fake_combine(combination_type type, const query_base &rhs) {
+    discard_statement_cache();
     switch (type) {
         case combination_type::union_:      _predicate = _predicate || rhs._predicate;  break;
         case combination_type::intersect:   _predicate = _predicate && rhs._predicate;  break;
@@ -300,22 +466,193 @@ query_base::add_fake_combine(combination_type type, const query_base &rhs) {
 
 void
 query_base::add_real_combine(combination_type type, bool all, const query_base &rhs) {
+    discard_statement_cache();
     _combinations.push_back(
         &own(quince::make_unique<combination>(type, all, clone(rhs)))
     );
 }
 
+bool
+query_base::fetch_any() const {
+    if (a_priori_empty())  return false;
+
+    unique_ptr<sql> cmd = _database.make_sql();
+    write_existence_select(*cmd);
+    cmd->bind_parameters(_bindings);
+    return _database.get_session()->exec_with_one_output(*cmd) != nullptr;
+}
+
+optional<uint64_t>
+query_base::fetch_size_estimate() const {
+    if (a_priori_empty())  return uint64_t(0);
+
+    return _database.estimate_row_count(*make_bound_select());
+}
+
 void
 query_base::init_iterator(query_iterator_base &iterator) const {
     if (a_priori_empty())  return;
 
-    const unique_ptr<sql> cmd = get_database().make_sql();
-    write_maximal_select(*cmd);
-    iterator.init(_database.get_session()->exec_with_stream_output(*cmd, _fetch_size));
+    iterator.init(_database.get_session()->exec_with_stream_output(*make_bound_select(), _fetch_size));
+}
+
+predicate
+query_base::keyset_predicate(const vector<cell> &key, bool after) const {
+    const vector<const abstract_mapper_base *> orders = all_orders_hi_to_lo();
+    if (orders.empty())  throw keyset_mismatch_exception();
+
+    return predicate(make_keyset_comparison_expressionist(clone_all(orders), key, after));
+}
+
+optional<query_base::semi_join>
+query_base::find_semi_join(const abstract_predicate &conjunct, const column_id_set &outer_ids) {
+    const auto * const exprn = dynamic_cast<const exprn_mapper_base *>(&conjunct);
+    if (! exprn)  return boost::none;
+
+    const auto test = exprn->dissect_as_subquery_test();
+    if (! test)  return boost::none;
+
+    // The subquery must filter a table, without limiting, grouping or aggregating, so that
+    // its effect is captured by its predicate alone.  (The limit that exists() adds doesn't matter.)
+    //
+    const column_mapper * const lhs = test->first;
+    const query_base &subquery = *test->second;
+    const table_base * const subquery_table = dynamic_cast<const table_base *>(&subquery._from);
+    if (   subquery_table == nullptr
+        || subquery_table->is_sampled()
+        || (! subquery._value_mapper_is_inherited  &&  might_aggregate(subquery.get_value_mapper_base()))
+        || (lhs != nullptr && subquery._limit)
+        || subquery._offset != 0
+        || subquery._distinct_list
+        || ! subquery._group_by.empty()
+        || subquery._row_lock
+        || ! subquery._combinations.empty()
+       )
+        return boost::none;
+
+    const auto is_local = [&](const abstract_mapper_base &m) {
+        return ! intersects(m.imports(), outer_ids);
+    };
+
+    semi_join result{subquery, {}, predicate(true)};
+
+    if (lhs != nullptr) {
+        // in(lhs, subquery): the subquery must be uncorrelated, and it becomes a join on
+        // lhs = the subquery's only column.
+        //
+        const column_mapper &inner = subquery.get_value_mapper_base().only_column();
+        if (! is_local(inner) || ! is_local(subquery._predicate))  return boost::none;
+
+        result._outer_inner_pairs.emplace_back(lhs, &inner);
+        result._local_predicate = subquery._predicate;
+        return result;
+    }
+
+    // exists(subquery): each conjunct of the subquery's predicate must be either local to
+    // the subquery, or an equality between an outer column and a local expression; and
+    // the latter become the join condition.
+    //
+    const auto * const sub_exprn = dynamic_cast<const exprn_mapper_base *>(&subquery._predicate);
+    const vector<const abstract_mapper_base *> * const parts =
+        sub_exprn ? sub_exprn->dissect_as_junction(sql::and_operator) : nullptr;
+    const vector<const abstract_mapper_base *> conjuncts = parts ? *parts : vector<const abstract_mapper_base *>{&subquery._predicate};
+
+    for (const abstract_mapper_base *c: conjuncts) {
+        const abstract_predicate &sub_conjunct = dynamic_cast<const abstract_predicate &>(*c);
+        if (is_local(sub_conjunct)) {
+            result._local_predicate = result._local_predicate && sub_conjunct;
+            continue;
+        }
+        const auto * const c_exprn = dynamic_cast<const exprn_mapper_base *>(&sub_conjunct);
+        const auto eq = c_exprn ? c_exprn->dissect_as_column_equality() : boost::none;
+        if (! eq)  return boost::none;
+
+        if (outer_ids.count(eq->first->id()) && is_local(*eq->second))
+            result._outer_inner_pairs.emplace_back(eq->first, eq->second);
+        else if (outer_ids.count(eq->second->id()) && is_local(*eq->first))
+            result._outer_inner_pairs.emplace_back(eq->second, eq->first);
+        else
+            return boost::none;
+    }
+    if (result._outer_inner_pairs.empty())  return boost::none;  // uncorrelated, so not worth it
+
+    return result;
+}
+
+void
+query_base::write_semi_join(sql &cmd, const semi_join &sj, const abstract_query_base &from) {
+    const query_base &subquery = sj._subquery;
+    cmd.add_parameter_bindings(subquery._bindings);
+
+    column_id_set inner_ids;
+    {
+        sql::wanted_aliases_scope wanted(cmd, universalizable_column_id_set::universal());
+
+        cmd.write(" INNER JOIN (SELECT ");
+        cmd.write_distinct();
+        {
+            sql::additional_aliased_columns_scope aliases(cmd, subquery._from.aliased_columns());
+            sql::comma_separated_list_scope list_scope(cmd);
+            for (const auto &p: sj._outer_inner_pairs)
+                if (inner_ids.insert(p.second->id()).second) {
+                    list_scope.start_item();
+                    cmd.write_select_list_item(*p.second);
+                }
+        }
+        cmd.write(" FROM ");
+        subquery._from.write_table_reference(cmd);
+        {
+            sql::additional_aliased_columns_scope aliases(cmd, subquery._from.aliased_columns());
+            if (! a_priori_true(sj._local_predicate))  cmd.write_where(sj._local_predicate);
+        }
+        cmd.write(") AS ");
+        cmd.write_next_subquery_alias();
+    }
+
+    sql::wanted_aliases_scope wanted(cmd, universalizable_column_id_set::universal());
+    sql::additional_aliased_columns_scope outer_aliases(cmd, from.aliased_columns());
+    sql::additional_aliased_columns_scope inner_aliases(cmd, inner_ids);
+    cmd.write(" ON ");
+    bool begun = false;
+    for (const auto &p: sj._outer_inner_pairs) {
+        if (begun)  cmd.write(sql::and_operator);
+        begun = true;
+        cmd.write_evaluation(*p.first);
+        cmd.write(" = ");
+        cmd.write_evaluation(*p.second);
+    }
+}
+
+void
+query_base::set_decorrelate() {
+    discard_statement_cache();
+    _decorrelate = true;
+}
+
+void
+query_base::set_row_lock(row_lock_type type) {
+    if (! _database.supports_row_locking())  throw unsupported_exception();
+
+    discard_statement_cache();
+    _row_lock = type;
+}
+
+void
+query_base::set_row_lock_wait(row_lock_wait wait) {
+    if (! _row_lock)  set_row_lock(row_lock_type::update);
+
+    discard_statement_cache();
+    _row_lock_wait = wait;
+}
+
+void
+query_base::add_binding(sql::parameter_id id, const cell &value) {
+    _bindings[id] = value;
 }
 
 void
 query_base::set_value_mapper_is_inherited(bool value_mapper_is_inherited) {
+    discard_statement_cache();
     _value_mapper_is_inherited = value_mapper_is_inherited;
 }
 
@@ -324,6 +661,7 @@ query_base::predicate_applicable_to(const table_base &t) const {
     const table_base * const from_table = dynamic_cast<const table_base *>(&_from);
     if (    from_table != nullptr
         &&  from_table->table_id() == t.table_id()
+        &&  ! from_table->is_sampled()
         &&  is_predicational()
        )
         return _predicate;
@@ -344,6 +682,18 @@ query_base::is_predicational() const {
         && _combinations.empty();
 }
 
+bool
+query_base::is_mergeable_subquery() const {
+    return (_value_mapper_is_inherited || ! might_aggregate(get_value_mapper_base()))
+        && !_limit
+        && _offset == 0
+        && ! _distinct_list
+        && _group_by.empty()
+        && _combinations.empty()
+        && _orders_lo_to_hi.empty()
+        && ! _row_lock;
+}
+
 bool
 query_base::is_combined() const {
     return !_combinations.empty();
@@ -373,6 +723,23 @@ query_base::imports() const {
     return result;
 }
 
+universalizable_column_id_set
+query_base::all_imports() const {
+    column_id_set result;
+    for (const query_base *q = this; ; ) {
+        if (! q->_combinations.empty())  return universalizable_column_id_set::universal();
+
+        add_to_set(result, q->imports());
+        add_to_set(result, q->additional_imports());
+        for (const abstract_mapper_base *g: q->_group_by)
+            add_to_set(result, g->imports());
+
+        if (dynamic_cast<const table_base *>(&q->_from))  return result;
+        q = dynamic_cast<const query_base *>(&q->_from);
+        if (q == nullptr)  return universalizable_column_id_set::universal();
+    }
+}
+
 const table_base &
 query_base::table() const {
     if (const table_base * const table = get_value_mapper_base()._table_whose_value_mapper_i_am)
@@ -0,0 +1,48 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <algorithm>
+#include <quince/detail/row.h>
+#include <quince/detail/session.h>
+#include <quince/detail/sql.h>
+#include <quince/query_batch.h>
+
+using std::vector;
+
+
+namespace quince {
+
+void
+batch_state::exec() {
+    // Only the entries that have statements are sent; the others produce no rows.
+    //
+    vector<const sql *> cmds;
+    vector<const entry *> senders;
+    uint32_t fetch_size = 0;
+    for (const entry &e: _pending)
+        if (e._cmd) {
+            cmds.push_back(e._cmd.get());
+            senders.push_back(&e);
+            fetch_size = std::max(fetch_size, e._fetch_size);
+        }
+
+    if (! cmds.empty())
+        try {
+            _database.get_session()->exec_batch_with_output(
+                cmds,
+                fetch_size,
+                [&](size_t i, const row &r) { senders[i]->_receive(r); }
+            );
+        }
+        catch (...) {
+            for (const entry &e: _pending)  e._reset();
+            throw;
+        }
+
+    for (const entry &e: _pending)  e._finish();
+    _pending.clear();
+}
+
+}
@@ -7,6 +7,7 @@
 #include <boost/optional.hpp>
 #include <quince/detail/row.h>
 #include <quince/detail/util.h>
+#include <quince/mappers/detail/column_mapper.h>
 
 using boost::optional;
 using std::string;
@@ -72,6 +73,22 @@ row::add_cells(const row &row) {
     add_cells(row._cells);
 }
 
+void
+row::replace_cell(size_t index, const cell &c) {
+    assert(index < _cells.size());
+    _cells[index] = c;
+}
+
+size_t
+row::size() const {
+    return _cells.size();
+}
+
+bool
+row::has_same_cells(const row &that) const {
+    return _cells == that._cells;
+}
+
 vector<cell>
 row::values() const {
     vector<cell> result;
@@ -81,6 +98,16 @@ row::values() const {
     return result;
 }
 
+vector<cell>
+row::cells_of(const abstract_column_sequence &columns) const {
+    vector<cell> result;
+    columns.for_each_column([&](const column_mapper &c) {
+        const cell * const found = find_cell(c.name());
+        result.push_back(found ? *found : cell());
+    });
+    return result;
+}
+
 optional<row>
 row::pick(const vector<string> &names) const {
     row r(_database);
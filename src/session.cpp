@@ -0,0 +1,28 @@
+//          Copyright Michael Shepanski 2014.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file ../LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <quince/detail/row.h>
+#include <quince/detail/session.h>
+
+using std::unique_ptr;
+using std::vector;
+
+
+namespace quince {
+
+void
+abstract_session_impl::exec_batch_with_output(
+    const vector<const sql *> &cmds,
+    uint32_t fetch_size,
+    const std::function<void(size_t, const row &)> &receive
+) {
+    for (size_t i = 0; i < cmds.size(); i++) {
+        const result_stream stream = exec_with_stream_output(*cmds[i], fetch_size);
+        while (const unique_ptr<row> r = next_output(stream))
+            receive(i, *r);
+    }
+}
+
+}
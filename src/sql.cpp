@@ -4,7 +4,10 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <assert.h>
+#include <algorithm>
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
@@ -15,7 +18,10 @@
 #include <quince/detail/query_base.h>
 #include <quince/mappers/detail/persistent_column_mapper.h>
 #include <quince/exprn_mappers/detail/lexicographic_comparison.h>
+#include <quince/exprn_mappers/operators.h>
+#include <quince/exprn_mappers/window.h>
 #include <quince/detail/sql.h>
+#include <quince/cte.h>
 #include <quince/query.h>
 #include <quince/table.h>
 
@@ -34,33 +40,58 @@ sql::sql(const database &db) :
     _database(&db),
     _input(&db),
     _wanted_aliases(universalizable_column_id_set::universal()),
+    _referenced_columns(universalizable_column_id_set::universal()),
     _nested_select(false),
     _implicit_table(boost::none),
-    _next_subquery_alias(0)
+    _filter(nullptr),
+    _window(nullptr),
+    _with_clause_claimed(false),
+    _with_recursive(false),
+    _next_subquery_alias(0),
+    _operand_renderings(nullptr)
 {}
 
 void
 sql::write(const string &s) {
-    _text.append(s);
+    target().append(s);
+}
+
+void
+sql::write(const char *s) {
+    target().append(s);
+}
+
+void
+sql::write(char c) {
+    target().push_back(c);
+}
+
+void
+sql::reserve(size_t n) {
+    _text.reserve(n);
 }
 
 void
 sql::write_quoted(const string &str) {
-    write('"' + str + '"');
+    string &t = target();
+    t.push_back('"');
+    t.append(str);
+    t.push_back('"');
 }
 
 void
 sql::write_quoted(const binomen &binomen) {
     if (binomen._enclosure) {
         write_quoted(*binomen._enclosure);
-        write(".");
+        write('.');
     }
     write_quoted(binomen._local);
 }
 
 void
 sql::write_next_subquery_alias() {
-    write("q$" + to_string(++_next_subquery_alias));
+    write("q$");
+    write(to_string(++_next_subquery_alias));
 }
 
 void
@@ -136,17 +167,35 @@ sql::write_rollback_transaction() {
 
 void
 sql::write_mark_save_point(const string &save_point) {
-    write("SAVEPOINT " + save_point);
+    write("SAVEPOINT ");
+    write(save_point);
 }
 
 void
 sql::write_forget_save_point(const string &save_point) {
-    write("RELEASE SAVEPOINT " + save_point);
+    write("RELEASE SAVEPOINT ");
+    write(save_point);
 }
 
 void
 sql::write_revert_to_save_point(const string &save_point) {
-    write("ROLLBACK TO " + save_point);
+    write("ROLLBACK TO ");
+    write(save_point);
+}
+
+void
+sql::write_advisory_lock(int64_t, advisory_lock_scope) {
+    throw unsupported_exception();
+}
+
+void
+sql::write_try_advisory_lock(int64_t, advisory_lock_scope) {
+    throw unsupported_exception();
+}
+
+void
+sql::write_advisory_unlock(int64_t) {
+    throw unsupported_exception();
 }
 
 void
@@ -173,19 +222,211 @@ sql::write_value(const cell &value) {
     attach_value(value);
 }
 
+void
+sql::write_parameter(parameter_id id) {
+    write(next_placeholder());
+    _parameter_slots.emplace_back(_input.size(), id);
+    if (const optional<const cell &> value = lookup(_parameter_bindings, id))
+        attach_cell(*value);
+    else
+        attach_cell(cell());
+}
+
+void
+sql::add_parameter_bindings(const parameter_bindings &bindings) {
+    _parameter_bindings.insert(bindings.begin(), bindings.end());
+}
+
+void
+sql::bind_parameters(const parameter_bindings &bindings) {
+    for (const auto &slot: _parameter_slots) {
+        optional<const cell &> value = lookup(bindings, slot.second);
+        if (! value)  value = lookup(_parameter_bindings, slot.second);
+        if (! value)  throw unbound_parameter_exception();
+
+        _input.replace_cell(slot.first, *value);
+    }
+}
+
+void
+sql::forget_parameter_bindings(const parameter_bindings &bindings) {
+    for (const auto &b: bindings)  _parameter_bindings.erase(b.first);
+}
+
 void
 sql::write_persistent_column(const string &table_name, const string &column_name) {
     if (_implicit_table)
         assert(table_name == *_implicit_table);
     else {
         write_quoted(table_name);
-        write(".");
+        write('.');
     }
     write_quoted(column_name);
 }
 
 void
 sql::write_function_call(const string &function_name, const vector<const column_mapper *> &args) {
+    write_function_name(function_name);
+    write('(');
+    comma_separated_list_scope list_scope(*this);
+    for (const auto arg: args) {
+        list_scope.start_item();
+        write_evaluation(*arg);
+    }
+    write(')');
+}
+
+void
+sql::write_cte_reference(const cte_base &c) {
+    write_quoted(c.name());
+    if (c.is_recursive())  _with_recursive = true;
+    if (c.definition() != nullptr)  _referenced_ctes.push_back(&c);
+}
+
+bool
+sql::write_cte_definitions(const vector<const cte_base *> &ctes) {
+    bool started = false;
+    for (const cte_base *c: ctes) {
+        if (! _defined_ctes.insert(c->name()).second)  continue;
+
+        if (started)  write(", ");
+        started = true;
+
+        const marker_t site = here();
+        write_quoted(c->name());
+        write(' ');
+        write_parenthesized_persistent_column_list(c->get_value_mapper_base());
+        write(" AS (");
+        {
+            aliased_columns_scope no_aliases(*this, column_id_set());
+            wanted_aliases_scope all_wanted(*this, universalizable_column_id_set::universal());
+            referenced_columns_scope all_referenced(*this, universalizable_column_id_set::universal());
+            c->definition()->write_maximal_select(*this);
+        }
+        write(')');
+
+        vector<const cte_base *> dependencies;
+        dependencies.swap(_referenced_ctes);
+        if (! dependencies.empty()) {
+            text_insertion_scope insertion(*this, site);
+            if (write_cte_definitions(dependencies))  write(", ");
+        }
+    }
+    return started;
+}
+
+void
+sql::write_aggregate_call(
+    const string &function_name,
+    const vector<const column_mapper *> &args,
+    bool distinct,
+    const column_mapper *ordered_by
+) {
+    // Take the pending filter and window, so that they aren't also put on some aggregate
+    // call within args.
+    //
+    const column_mapper * const filter = _filter;
+    const window_definition * const window = _window;
+    _filter = nullptr;
+    _window = nullptr;
+
+    // If the DBMS doesn't support FILTER, then the aggregated expression is replaced by
+    // "CASE WHEN filter THEN expression END", which is null where filter is not true, so
+    // the function ignores it.  The aggregated expression is ordered_by if there is one,
+    // else the first arg.  COUNT(*)'s "*" can't go in a CASE, so it becomes 1.
+    //
+    const bool emulate_filter = filter != nullptr && ! get_database().supports_aggregate_filter();
+    const auto write_aggregated = [&](const column_mapper &c, bool guarded) {
+        if (! guarded)  return write_evaluation(c);
+
+        write("CASE WHEN ");
+        write_evaluation(*filter);
+        write(" THEN ");
+        const marker_t start = here();
+        write_evaluation(c);
+        string &text = target();
+        if (text.compare(start, string::npos, "*") == 0)  text.replace(start, 1, "1");
+        write(" END");
+    };
+
+    write_function_name(function_name);
+    write('(');
+    if (distinct)  write("DISTINCT ");
+    {
+        comma_separated_list_scope list_scope(*this);
+        for (const column_mapper *a: args) {
+            list_scope.start_item();
+            write_aggregated(*a, emulate_filter && ordered_by == nullptr && a == args.front());
+        }
+    }
+    write(')');
+    if (ordered_by != nullptr) {
+        write(" WITHIN GROUP (ORDER BY ");
+        write_aggregated(*ordered_by, emulate_filter);
+        write(')');
+    }
+    if (filter != nullptr && ! emulate_filter) {
+        write(" FILTER (WHERE ");
+        write_evaluation(*filter);
+        write(')');
+    }
+    if (window != nullptr) {
+        write(" OVER ");
+        write_window(*window);
+    }
+}
+
+void
+sql::write_window(const window_definition &window) {
+    write('(');
+    bool started = false;
+    const auto separate = [&] {
+        if (started)  write(' ');
+        started = true;
+    };
+
+    if (! window._partitions.empty()) {
+        separate();
+        write("PARTITION BY ");
+        comma_separated_list_scope list_scope(*this);
+        for (const auto &p: window._partitions)
+            p->for_each_column([&](const column_mapper &c) {
+                list_scope.start_item();
+                write_evaluation(c);
+            });
+    }
+    if (! window._orders.empty()) {
+        separate();
+        write("ORDER BY ");
+        write_order_list(transform(
+            window._orders,
+            [](const std::shared_ptr<const abstract_mapper_base> &o)  { return o.get(); }
+        ));
+    }
+    if (const auto &frame = window._frame) {
+        separate();
+        write(frame->_range ? "RANGE BETWEEN " : "ROWS BETWEEN ");
+        write_frame_bound(frame->_start);
+        write(" AND ");
+        write_frame_bound(frame->_end);
+    }
+    write(')');
+}
+
+void
+sql::write_frame_bound(const frame_bound &bound) {
+    switch (bound._kind) {
+        case frame_bound::kind::unbounded_preceding:    write("UNBOUNDED PRECEDING"); break;
+        case frame_bound::kind::preceding:              write(to_string(bound._offset)); write(" PRECEDING"); break;
+        case frame_bound::kind::current_row:            write("CURRENT ROW"); break;
+        case frame_bound::kind::following:              write(to_string(bound._offset)); write(" FOLLOWING"); break;
+        case frame_bound::kind::unbounded_following:    write("UNBOUNDED FOLLOWING"); break;
+        default:                                        abort();
+    }
+}
+
+void
+sql::write_function_name(const string &function_name) {
     // If function_name contains caps then it must be quoted.  Otherwise it doesn't
     // need to be quoted and, in case of certain built-ins may need not to be.
     //
@@ -195,44 +436,141 @@ sql::write_function_call(const string &function_name, const vector<const column_
         write(function_name);
     else
         write_quoted(function_name);
-    
-    write("(");
-    comma_separated_list_scope list_scope(*this);
-    for (const auto arg: args) {
-        list_scope.start_item();
-        write_evaluation(*arg);
-    }
-    write(")");
 }
 
 void
 sql::write_prefix_exprn(const string &op, const column_mapper &operand) {
-    write(op + "(");
+    write(op);
+    write('(');
     write_evaluation(operand);
-    write(")");
+    write(')');
 }
 
 void
 sql::write_postfix_exprn(const column_mapper &operand, const string &op) {
-    write("(");
+    write('(');
     write_evaluation(operand);
-    write(")" + op);
+    write(')');
+    write(op);
 }
 
 void
 sql::write_infix_exprn(const column_mapper &lhs, const string &op, const column_mapper &rhs) {
-    write("(");
+    write('(');
     write_evaluation(lhs);
-    write(")" + op + "(");
+    write(')');
+    write(op);
+    write('(');
     write_evaluation(rhs);
-    write(")");
+    write(')');
+}
+
+void
+sql::write_junction(const string &op, const vector<const abstract_mapper_base *> &operands) {
+    // The outermost junction in the statement provides the operand_renderings for all
+    // the others.
+    //
+    struct renderings_scope {
+        sql &_cmd;
+        operand_renderings _renderings;
+        const bool _is_outermost;
+
+        explicit renderings_scope(sql &cmd) :
+            _cmd(cmd),
+            _is_outermost(cmd._operand_renderings == nullptr)
+        {
+            if (_is_outermost)  _cmd._operand_renderings = &_renderings;
+        }
+
+        ~renderings_scope() {
+            if (_is_outermost)  _cmd._operand_renderings = nullptr;
+        }
+    } renderings(*this);
+
+    // Find the distinct operands, identifying each one by its rendering.
+    //
+    std::unordered_map<string, vector<const sql *>> seen;
+    vector<const abstract_mapper_base *> distinct;
+    for (const abstract_mapper_base *o: operands) {
+        const sql &rendering = operand_rendering(*o);
+        vector<const sql *> &same_text = seen[rendering.get_text()];
+        const bool is_duplicate = std::any_of(
+            same_text.begin(),
+            same_text.end(),
+            [&](const sql *s) { return s->is_same_rendering(rendering); }
+        );
+        if (! is_duplicate) {
+            distinct.push_back(o);
+            same_text.push_back(&rendering);
+        }
+    }
+
+    // For an OR, gather the values that each column is tested for equality with.
+    //
+    struct equalities {
+        const abstract_mapper_base *_first;
+        const column_mapper *_column;
+        vector<cell> _values;
+    };
+    std::map<column_id, equalities> equalities_by_column;
+    std::map<const abstract_mapper_base *, const equalities *> merged;
+    if (op == or_operator) {
+        for (const abstract_mapper_base *o: distinct)
+            if (const auto * const exprn = dynamic_cast<const exprn_mapper_base *>(o))
+                if (const auto eq = exprn->dissect_as_value_equality(*_database)) {
+                    const auto inserted = equalities_by_column.insert({eq->first->id(), {o, eq->first, {}}});
+                    inserted.first->second._values.push_back(eq->second);
+                    merged[o] = &inserted.first->second;
+                }
+        for (auto i = merged.begin(); i != merged.end(); )
+            if (i->second->_values.size() < 2)  i = merged.erase(i);
+            else                                ++i;
+    }
+
+    bool begun = false;
+    for (const abstract_mapper_base *o: distinct) {
+        const auto m = merged.find(o);
+        if (m != merged.end()  &&  m->second->_first != o)  continue;
+
+        if (begun)  write(op);
+        begun = true;
+        write('(');
+        if (m != merged.end())
+            write_in_array(*m->second->_column, m->second->_values);
+        else
+            write_evaluation(o->only_column());
+        write(')');
+    }
+}
+
+const sql &
+sql::operand_rendering(const abstract_mapper_base &operand) {
+    unique_ptr<sql> &result = (*_operand_renderings)[&operand];
+    if (! result) {
+        result = _database->make_sql();
+        result->_operand_renderings = _operand_renderings;
+        wanted_aliases_scope wanted(*result, universalizable_column_id_set::universal());
+        result->write_evaluation(operand.only_column());
+    }
+    return *result;
+}
+
+bool
+sql::is_same_rendering(const sql &that) const {
+    // Each param is identified by its id, since its value may not be known yet.
+    //
+    return _text == that._text
+        && _parameter_slots == that._parameter_slots
+        && _input.has_same_cells(that._input);
 }
 
 void
 sql::write_cast(const column_mapper &arg, const column_type cast_type) {
     write("CAST (");
     write_evaluation(arg);
-    write(" AS " + column_type_name(cast_type) + ")");
+    write(" AS ");
+    write(column_type_name(cast_type));
+    write(')');
 }
 
 void
@@ -264,8 +602,13 @@ sql::write_scalar_subquery(const query_base &query) {
 
 void
 sql::write_subquery_exists(const query_base &query) {
-    write("EXISTS");
-    write_subquery_exprn(query);
+    assert(!_implicit_table);
+    write("EXISTS(");
+    {
+        nested_select_scope nested(*this);
+        query.write_existence_select(*this);
+    }
+    write(")");
 }
 
 void
@@ -280,6 +623,37 @@ sql::write_in(const column_mapper &lhs, const vector<const column_mapper *> &rhs
     write(")");
 }
 
+void
+sql::write_in_array(const column_mapper &lhs, const vector<cell> &values) {
+    assert(! values.empty());
+
+    // Long lists are split into chunks of max_chunk_size, and the last chunk is padded
+    // with copies of its last value, up to the next power of two.
+    //
+    const size_t max_chunk_size = 256;
+    const size_t n_chunks = (values.size() + max_chunk_size - 1) / max_chunk_size;
+
+    if (n_chunks > 1)  write('(');
+    for (size_t c = 0; c < n_chunks; c++) {
+        if (c > 0)  write(" OR ");
+
+        const size_t begin = c * max_chunk_size;
+        const size_t end = std::min(begin + max_chunk_size, values.size());
+        size_t padded_size = 1;
+        while (padded_size < end - begin)  padded_size *= 2;
+
+        write_evaluation(lhs);
+        write(" IN (");
+        comma_separated_list_scope list_scope(*this);
+        for (size_t i = 0; i < padded_size; i++) {
+            list_scope.start_item();
+            write_value(values[std::min(begin + i, end - 1)]);
+        }
+        write(")");
+    }
+    if (n_chunks > 1)  write(')');
+}
+
 void
 sql::write_in(const column_mapper &lhs, const query_base &rhs) {
     write_evaluation(lhs);
@@ -339,6 +713,57 @@ sql::write_extrinsic_comparison(relation r, const abstract_column_sequence &lhs,
     write_lexicographic_comparison(r, lhs_thunks, rhs_thunks);
 }
 
+void
+sql::write_keyset_comparison(
+    const vector<const abstract_mapper_base *> &orders_hi_to_lo,
+    const vector<cell> &key,
+    bool after
+) {
+    vector<thunk> lhs_thunks;
+    vector<thunk> rhs_thunks;
+    vector<bool> inversions;
+    for (const abstract_mapper_base *o: orders_hi_to_lo) {
+        const auto pair = o->dissect_as_order_specification();
+        pair.first->for_each_column([&](const column_mapper &c) {
+            if (inversions.size() == key.size())  throw keyset_mismatch_exception();
+
+            const cell &value = key[inversions.size()];
+            lhs_thunks.push_back([&](sql &cmd) {
+                cmd.write_evaluation(c);
+            });
+            const string r = next_value_reference(value);
+            rhs_thunks.push_back([=](sql &cmd) {
+                cmd.write(r);
+            });
+            attach_value(value);
+            inversions.push_back(pair.second);
+        });
+    }
+    if (inversions.empty() || inversions.size() != key.size())
+        throw keyset_mismatch_exception();
+
+    const auto relation_at = [&](size_t i) {
+        return after != inversions[i] ? relation::greater : relation::less;
+    };
+
+    if (std::all_of(inversions.begin(), inversions.end(), [&](bool b) { return b == inversions.front(); }))
+        return write_lexicographic_comparison(relation_at(0), lhs_thunks, rhs_thunks);
+
+    // Mixed directions, so each column needs its own comparison operator.
+    //
+    const size_t n = lhs_thunks.size();
+    size_t i;
+    for (i = 0; i < n-1; i++) {
+        write_simple_comparison(relop(relation_at(i)), lhs_thunks[i], rhs_thunks[i]);
+        write(" OR ");
+        write_simple_comparison(relop(relation::equal), lhs_thunks[i], rhs_thunks[i]);
+        write(" AND (");
+    }
+    write_simple_comparison(relop(relation_at(i)), lhs_thunks[i], rhs_thunks[i]);
+    while (i --> 0)
+        write(")");
+}
+
 void
 sql::write_collective_comparison(relation r, const abstract_column_sequence &lhs, const collective_base &rhs) {
     throw unsupported_exception();
@@ -363,28 +788,106 @@ sql::write_returning(const abstract_mapper_base &mapper) {
 
 void
 sql::write_limit(uint32_t n) {
-    write(" LIMIT " + to_string(n));
+    write(" LIMIT ");
+    write(to_string(n));
 }
 
 void
 sql::write_offset(uint32_t n) {
-    write(" OFFSET " + to_string(n));
+    write(" OFFSET ");
+    write(to_string(n));
 }
 
 void
-sql::write_group_by(const vector<const abstract_mapper_base *> &group_by) {
-    write(" GROUP BY ");
-    comma_separated_list_scope list_scope(*this);
-    for (const abstract_mapper_base *g: group_by)
-        g->for_each_column([&](const column_mapper &c) {
+sql::write_group_by(
+    const vector<const abstract_mapper_base *> &group_by,
+    grouping_type type,
+    const vector<vector<size_t>> &grouping_sets
+) {
+    // Write the columns of all the mappers in group_by as one comma-separated list.
+    //
+    const auto write_columns = [&](const vector<const abstract_mapper_base *> &mappers) {
+        comma_separated_list_scope list_scope(*this);
+        for (const abstract_mapper_base *g: mappers)
+            g->for_each_column([&](const column_mapper &c) {
+                list_scope.start_item();
+                write_evaluation(c);
+            });
+    };
+
+    // Write each mapper in group_by as one item, so that a multi-column mapper is rolled
+    // up (or whatever) as a unit.
+    //
+    const auto write_items = [&] {
+        comma_separated_list_scope list_scope(*this);
+        for (const abstract_mapper_base *g: group_by) {
             list_scope.start_item();
-            write_evaluation(c);
-        });
+            const bool parenthesize = g->size() != 1;
+            if (parenthesize)  write('(');
+            write_columns({ g });
+            if (parenthesize)  write(')');
+        }
+    };
+
+    write(" GROUP BY ");
+    switch (type) {
+        case grouping_type::plain:
+            write_columns(group_by);
+            break;
+
+        case grouping_type::rollup:
+            write("ROLLUP (");
+            write_items();
+            write(')');
+            break;
+
+        case grouping_type::cube:
+            write("CUBE (");
+            write_items();
+            write(')');
+            break;
+
+        case grouping_type::sets: {
+            write("GROUPING SETS (");
+            comma_separated_list_scope list_scope(*this);
+            for (const vector<size_t> &set: grouping_sets) {
+                list_scope.start_item();
+                write('(');
+                write_columns(transform(set, [&](size_t i)  { return group_by.at(i); }));
+                write(')');
+            }
+            write(')');
+            break;
+        }
+
+        default:
+            abort();
+    }
 }
 
 void
 sql::write_ordered_by(const vector<const abstract_mapper_base *> &orders) {
     write(" ORDER BY ");
+    write_order_list(orders);
+}
+
+void
+sql::write_row_lock(row_lock_type type, row_lock_wait wait) {
+    switch (type) {
+        case row_lock_type::update: write(" FOR UPDATE"); break;
+        case row_lock_type::share:  write(" FOR SHARE"); break;
+        default:                    abort();
+    }
+    switch (wait) {
+        case row_lock_wait::wait:           break;
+        case row_lock_wait::nowait:         write(" NOWAIT"); break;
+        case row_lock_wait::skip_locked:    write(" SKIP LOCKED"); break;
+        default:                            abort();
+    }
+}
+
+void
+sql::write_order_list(const vector<const abstract_mapper_base *> &orders) {
     comma_separated_list_scope list_scope(*this);
     for (const abstract_mapper_base *o: orders) {
         const auto pair = o->dissect_as_order_specification();
@@ -468,6 +971,63 @@ sql::write_qualified_join(
     rhs.write_table_reference(*this);
 }
 
+void
+sql::write_lateral_join(
+    const abstract_query_base &lhs,
+    const abstract_query_base &rhs,
+    conditional_junction_type type
+) {
+    // rhs may refer to lhs's columns anywhere, not just in its select list, so e.g. a left
+    // join in lhs mustn't be eliminated for want of references to its rhs.
+    //
+    const query_base * const rhs_query = dynamic_cast<const query_base *>(&rhs);
+    {
+        additional_wanted_aliases_scope wanted(*this, rhs.imports());
+        additional_referenced_columns_scope referenced(*this, rhs_query ? rhs_query->all_imports() : rhs.imports());
+        lhs.write_table_reference(*this);
+    }
+    switch(type) {
+        case conditional_junction_type::inner:  write(" CROSS"); break;
+        case conditional_junction_type::left:   write(" LEFT"); break;
+        default:                                abort();
+    }
+    write(" JOIN LATERAL ");
+    {
+        additional_aliased_columns_scope aliases(*this, lhs.aliased_columns());
+        rhs.write_table_reference(*this);
+    }
+    if (type == conditional_junction_type::left)  write(" ON TRUE");
+}
+
+void
+sql::write_table_sample(const table_sample &sample) {
+    write(" TABLESAMPLE ");
+    switch (sample._method) {
+        case sample_method::system:     write("SYSTEM"); break;
+        case sample_method::bernoulli:  write("BERNOULLI"); break;
+        default:                        abort();
+    }
+    write(" (" + (format("%1%") % sample._percent).str() + ")");
+    if (sample._seed)  write(" REPEATABLE (" + to_string(*sample._seed) + ")");
+}
+
+void
+sql::write_random_sample(const string &quoted_table, const string &local_name, const table_sample &sample) {
+    if (sample._seed)  throw unsupported_exception();
+
+    write("(SELECT * FROM ");
+    write(quoted_table);
+    write(" WHERE ");
+    write_random_test(sample._percent / 100);
+    write(") AS ");
+    write_quoted(local_name);
+}
+
+void
+sql::write_random_test(double) {
+    throw unsupported_exception();
+}
+
 void
 sql::write_combination(combination_type type, bool all, const query_base &rhs) {
     switch (type) {
@@ -538,6 +1098,81 @@ sql::write_update(
     });
 }
 
+void
+sql::write_update_from(
+    const binomen &table,
+    const abstract_mapper_base &dest,
+    const abstract_mapper_base &src,
+    const abstract_query_base &source,
+    const abstract_predicate &on,
+    const abstract_predicate &pred,
+    optional<column_id> excluded
+) {
+    vector<const column_mapper *> src_columns;
+    src.for_each_column([&](const column_mapper &c) {
+        src_columns.push_back(&c);
+    });
+    auto src_column_iter = src_columns.begin();
+
+    const bool from = _database->supports_update_from();
+    const column_id_set source_aliases = source.aliased_columns();
+    const optional<marker_t> with_site = begin_with_clause();  // in case source is or uses a cte
+
+    // " FROM <source> WHERE on", as used in the correlated subqueries.
+    //
+    const auto write_matching_rows = [&] {
+        write(" FROM ");
+        source.write_table_reference(*this);
+        aliased_columns_scope aliases(*this, source_aliases);
+        if (! a_priori_true(on))  write_where(on);
+    };
+
+    write("UPDATE ");
+    write_quoted(table);
+    write(" SET ");
+    comma_separated_list_scope list_scope(*this);
+    dest.for_each_persistent_column([&](const persistent_column_mapper &p) {
+        if (p.id() != excluded) {
+            list_scope.start_item();
+            write_quoted(p.name());
+            write(" = ");
+            const column_mapper &s = **src_column_iter++;
+            if (from) {
+                aliased_columns_scope aliases(*this, source_aliases);
+                write_evaluation(s);
+            }
+            else {
+                write("(SELECT ");
+                {
+                    aliased_columns_scope aliases(*this, source_aliases);
+                    write_evaluation(s);
+                }
+                write_matching_rows();
+                write_limit(1);
+                write(")");
+            }
+        }
+    });
+
+    if (from) {
+        write(" FROM ");
+        source.write_table_reference(*this);
+        aliased_columns_scope aliases(*this, source_aliases);
+        const predicate condition = on && pred;
+        if (! a_priori_true(condition))  write_where(condition);
+    }
+    else {
+        write(" WHERE EXISTS(SELECT 1");
+        write_matching_rows();
+        write(")");
+        if (! a_priori_true(pred)) {
+            write(" AND ");
+            write_evaluation(predicate(pred));
+        }
+    }
+    if (with_site)  end_with_clause(*with_site);
+}
+
 void
 sql::write_delete_from(const binomen &table) {
     write("DELETE FROM ");
@@ -612,21 +1247,68 @@ sql::alias_is_defined(column_id r) const {
     return _aliased_columns.count(r) != 0;
 }
 
+bool
+sql::column_is_referenced(column_id id) const {
+    return _referenced_columns.count(id) != 0;
+}
+
 sql::marker_t
 sql::here() const {
-    return _text.length();
+    return _pending_insertions.empty()
+        ? _text.length()
+        : _pending_insertions.back().second.length();
+}
+
+optional<sql::marker_t>
+sql::begin_with_clause() {
+    if (_with_clause_claimed)  return boost::none;
+
+    _with_clause_claimed = true;
+    return here();
+}
+
+void
+sql::end_with_clause(marker_t site) {
+    assert(_with_clause_claimed);
+
+    vector<const cte_base *> ctes;
+    ctes.swap(_referenced_ctes);
+    if (! ctes.empty()) {
+        text_insertion_scope insertion(*this, site);
+        write("WITH ");
+        const marker_t site_for_recursive = here();
+        write_cte_definitions(ctes);
+        write(' ');
+        if (_with_recursive) {
+            text_insertion_scope recursive_insertion(*this, site_for_recursive);
+            write("RECURSIVE ");
+        }
+    }
+    _with_clause_claimed = false;
+    _with_recursive = false;
+    _defined_ctes.clear();
+}
+
+string &
+sql::target() {
+    return _pending_insertions.empty()
+        ? _text
+        : _pending_insertions.back().second;
 }
 
 sql::text_insertion_scope::text_insertion_scope(sql &cmd, marker_t insertion_point) :
-    _command(cmd),
-    _pending_tail(_command._text.substr(insertion_point))
+    _command(cmd)
 {
-    _command._text.erase(insertion_point);
+    assert(insertion_point <= _command.here());
+    _command._pending_insertions.emplace_back(insertion_point, string());
 }
 
 sql::text_insertion_scope::~text_insertion_scope()
 {
-    _command._text.append(_pending_tail);
+    std::pair<marker_t, string> insertion;
+    insertion.swap(_command._pending_insertions.back());
+    _command._pending_insertions.pop_back();
+    _command.target().insert(insertion.first, insertion.second);
 }
 
 
@@ -675,6 +1357,35 @@ sql::additional_wanted_aliases_scope::additional_wanted_aliases_scope(
 }
 
 
+sql::referenced_columns_scope::referenced_columns_scope(
+    sql &cmd,
+    const universalizable_column_id_set &referenced
+) :
+    referenced_columns_scope(cmd)
+{
+    _command._referenced_columns = referenced;
+}
+
+sql::referenced_columns_scope::~referenced_columns_scope() {
+    _command._referenced_columns = _pending;
+}
+
+sql::referenced_columns_scope::referenced_columns_scope(sql &cmd) :
+    _command(cmd),
+    _pending(cmd._referenced_columns)
+{}
+
+
+sql::additional_referenced_columns_scope::additional_referenced_columns_scope(
+    sql &cmd,
+    const universalizable_column_id_set &additional_referenced
+) :
+    referenced_columns_scope(cmd)
+{
+    cmd._referenced_columns.insert(additional_referenced);
+}
+
+
 sql::aliased_columns_scope::aliased_columns_scope(sql &cmd, const column_id_set &aliaseds) :
     aliased_columns_scope(cmd)
 {
@@ -703,13 +1414,30 @@ sql::additional_aliased_columns_scope::additional_aliased_columns_scope(
 
 sql::nested_select_scope::nested_select_scope(sql &cmd) :
     _command(cmd),
-    _pending(cmd._nested_select)
+    _pending(cmd._nested_select),
+    _pending_operand_renderings(cmd._operand_renderings),
+    _pending_window(cmd._window),
+    _pending_filter(cmd._filter)
 {
     _command._nested_select = true;
+
+    // The subquery may write predicates that it makes on the fly, so its junctions get
+    // their own operand_renderings, which don't outlive those predicates.
+    //
+    _command._operand_renderings = nullptr;
+
+    // A pending window or filter belongs to an aggregate call in the enclosing select,
+    // not to one in the subquery.
+    //
+    _command._window = nullptr;
+    _command._filter = nullptr;
 }
 
 sql::nested_select_scope::~nested_select_scope() {
     _command._nested_select = _pending;
+    _command._operand_renderings = _pending_operand_renderings;
+    _command._window = _pending_window;
+    _command._filter = _pending_filter;
 }
 
 
@@ -725,8 +1453,46 @@ sql::expression_restriction_scope::~expression_restriction_scope() {
 }
 
 
+sql::filter_scope::filter_scope(sql &cmd, const column_mapper &predicate) :
+    _command(cmd),
+    _pending(&predicate),
+    _previous(cmd._filter)
+{
+    _command._filter = _pending;
+}
+
+sql::filter_scope::~filter_scope() {
+    _command._filter = _previous;
+}
+
+bool
+sql::filter_scope::is_used() const {
+    return _command._filter != _pending;
+}
+
+
+sql::window_scope::window_scope(sql &cmd, const window_definition &window) :
+    _command(cmd),
+    _pending(&window),
+    _previous(cmd._window)
+{
+    _command._window = _pending;
+}
+
+sql::window_scope::~window_scope() {
+    _command._window = _previous;
+}
+
+bool
+sql::window_scope::is_used() const {
+    return _command._window != _pending;
+}
+
+
 const string sql::unary_plus_operator = "+";
 const string sql::unary_minus_operator = "-";
+const string sql::and_operator = " AND ";
+const string sql::or_operator = " OR ";
 
 
 void
@@ -735,7 +1501,8 @@ sql::write_select_list_item(const column_mapper &c) {
         write(c.alias());
     else {
         c.write_expression(*this);
-        write(" AS " + c.alias());
+        write(" AS ");
+        write(c.alias());
     }
 }
 
@@ -824,7 +1591,7 @@ sql::write_nesting_lexicographic_comparison(
     for (i = 0; i < n-1; i++) {
         write_simple_comparison(strict_compare_op, lhs[i], rhs[i]);
         write(" OR ");
-        write_simple_comparison(compare_op, lhs[i], rhs[i]);
+        write_simple_comparison(relop(relation::equal), lhs[i], rhs[i]);
         write(" AND (");
     }
     write_simple_comparison(compare_op, lhs[i], rhs[i]);
@@ -832,9 +1599,33 @@ sql::write_nesting_lexicographic_comparison(
         write(")");
 }
 
+void
+sql::write_row_value_comparison(
+    const string &compare_op,
+    const vector<thunk> &lhs,
+    const vector<thunk> &rhs
+) {
+    assert(rhs.size() == lhs.size());
+    const auto write_row_value = [&](const vector<thunk> &thunks) {
+        write('(');
+        comma_separated_list_scope list_scope(*this);
+        for (const thunk &t: thunks) {
+            list_scope.start_item();
+            t(*this);
+        }
+        write(')');
+    };
+    write_row_value(lhs);
+    write(compare_op);
+    write_row_value(rhs);
+}
+
 void
 sql::write_lexicographic_comparison(relation r, const vector<thunk> &lhs, const vector<thunk> &rhs) {
     const string op = relop(r);
+    if (lhs.size() > 1  &&  _database->supports_row_value_comparison())
+        return write_row_value_comparison(op, lhs, rhs);
+
     switch (r) {
         case relation::equal:       return write_flat_lexicographic_comparison(op, " AND ", lhs, rhs);
         case relation::not_equal:   return write_flat_lexicographic_comparison(op, " OR ", lhs, rhs);
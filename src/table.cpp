@@ -4,6 +4,7 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <assert.h>
+#include <quince/detail/query_base.h>
 #include <quince/detail/sql.h>
 #include <quince/table.h>
 #include <quince/transaction.h>
@@ -91,45 +92,82 @@ table_base::sql_insert(const row &input) {
     return result;
 }
 
+optional<uint64_t>
+table_base::insert_from(const query_base &source) const {
+    if (source.a_priori_empty())  return uint64_t(0);
+
+    const unique_ptr<sql> cmd = _database.make_sql();
+    cmd->write_insert(_binomen, _value_mapper, readback_id());
+    cmd->write(" ");
+    source.write_maximal_select(*cmd);
+    cmd->bind_parameters(sql::parameter_bindings());
+    return _database.get_session()->exec_with_row_count(*cmd);
+}
+
 
 template<typename Src>
-void
+optional<uint64_t>
 table_base::update_with_no_output(
     const abstract_mapper_base &dest,
     const Src &src,
-    const abstract_predicate &pred
+    const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings
 ) const {
-    _database.get_session()->exec(
-        *sql_update(dest, src, pred)
+    return _database.get_session()->exec_with_row_count(
+        *sql_update(dest, src, pred, bindings)
     );
 }
 template
-void
+optional<uint64_t>
 table_base::update_with_no_output<abstract_mapper_base>(
     const abstract_mapper_base &,
     const abstract_mapper_base &,
-    const abstract_predicate &
+    const abstract_predicate &,
+    const sql::parameter_bindings &
 ) const;
 template
-void
+optional<uint64_t>
 table_base::update_with_no_output<row>(
     const abstract_mapper_base &,
     const row &,
-    const abstract_predicate &
+    const abstract_predicate &,
+    const sql::parameter_bindings &
 ) const;
 
 
+optional<uint64_t>
+table_base::update_with_source(
+    const abstract_mapper_base &dest,
+    const abstract_mapper_base &src,
+    const abstract_query_base &source,
+    const abstract_predicate &on,
+    const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings
+) const {
+    if (! is_subset(dest.columns(), _value_mapper.columns()))
+        throw outside_table_exception(_binomen);
+    if (a_priori_false(pred)  ||  a_priori_false(on)  ||  source.a_priori_empty())
+        return uint64_t(0);
+
+    const unique_ptr<sql> cmd = _database.make_sql();
+    cmd->write_update_from(_binomen, dest, src, source, on, pred, readback_id());
+    cmd->bind_parameters(bindings);
+    return _database.get_session()->exec_with_row_count(*cmd);
+}
+
+
 template<typename Src>
 result_stream
 table_base::update_with_stream_output(
     const abstract_mapper_base &dest,
     const Src &src,
     const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings,
     const abstract_mapper_base &returning,
     uint32_t fetch_size
 ) const {
     return _database.get_session()->exec_with_stream_output(
-        *sql_update(dest, src, pred, &returning),
+        *sql_update(dest, src, pred, bindings, &returning),
         fetch_size
     );
 }
@@ -139,6 +177,7 @@ table_base::update_with_stream_output<abstract_mapper_base>(
     const abstract_mapper_base &,
     const abstract_mapper_base &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base &,
     uint32_t
 ) const;
@@ -148,6 +187,7 @@ table_base::update_with_stream_output<row>(
     const abstract_mapper_base &,
     const row &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base &,
     uint32_t
 ) const;
@@ -159,10 +199,11 @@ table_base::update_with_one_output(
     const abstract_mapper_base &dest,
     const Src &src,
     const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings,
     const abstract_mapper_base &returning
 ) const {
     return _database.get_session()->exec_with_one_output(
-        *sql_update(dest, src, pred, &returning)
+        *sql_update(dest, src, pred, bindings, &returning)
     );
 }
 template
@@ -171,6 +212,7 @@ table_base::update_with_one_output<abstract_mapper_base>(
     const abstract_mapper_base &,
     const abstract_mapper_base &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base &
 ) const;
 template
@@ -179,6 +221,7 @@ table_base::update_with_one_output<row>(
     const abstract_mapper_base &,
     const row &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base &
 ) const;
 
@@ -187,7 +230,21 @@ void
 table_base::write_table_reference(sql &cmd) const {
     if (!_is_open)  throw table_closed_exception();
 
-    cmd.write_quoted(_binomen);
+    if (! _sample)
+        cmd.write(_quoted_binomen);
+    else if (_database.supports_table_sample(_sample->_method)) {
+        cmd.write(_quoted_binomen);
+        cmd.write_table_sample(*_sample);
+    }
+    else
+        cmd.write_random_sample(_quoted_binomen, _binomen._local, *_sample);
+}
+
+void
+table_base::set_sample(const table_sample &sample) {
+    if (! (sample._percent >= 0  &&  sample._percent <= 100))  throw sample_exception(sample._percent);
+
+    _sample = sample;
 }
 
 column_id_set 
@@ -200,30 +257,60 @@ table_base::for_each_column(std::function<void(const column_mapper &)> op) const
     _value_mapper.for_each_column(op);
 }
 
-void
-table_base::remove_where(const abstract_predicate &pred) const {
-    if (a_priori_false(pred))  return;
+optional<uint64_t>
+table_base::remove_where(const abstract_predicate &pred, const sql::parameter_bindings &bindings) const {
+    if (a_priori_false(pred))  return uint64_t(0);
 
-    const unique_ptr<sql> cmd = clone(_sql_delete);
-    if (! a_priori_true(pred))
-        cmd->write_where(pred);
-    _database.get_session()->exec(*cmd);
+    return _database.get_session()->exec_with_row_count(*sql_delete(pred, bindings));
+}
+
+result_stream
+table_base::remove_with_stream_output(
+    const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings,
+    const abstract_mapper_base &returning,
+    uint32_t fetch_size
+) const {
+    return _database.get_session()->exec_with_stream_output(
+        *sql_delete(pred, bindings, &returning),
+        fetch_size
+    );
 }
 
 void
-table_base::remove_existing_where(const abstract_predicate &pred) const {
-    if (! remove_if_exists_where(pred))
+table_base::remove_existing_where(const abstract_predicate &pred, const sql::parameter_bindings &bindings) const {
+    if (! remove_if_exists_where(pred, bindings))
         throw no_row_exception();
 }
 
 bool
-table_base::remove_if_exists_where(const abstract_predicate &pred) const {
-    if (empty_impl(pred))  return false;
+table_base::remove_if_exists_where(const abstract_predicate &pred, const sql::parameter_bindings &bindings) const {
+    if (a_priori_false(pred))  return false;
 
-    remove_where(pred);
+    // If the DBMS reports how many rows the DELETE removed, then that's all we need.
+    // Otherwise we have to look first, which takes two round trips.
+    //
+    // If a count was promised but doesn't come back, the DELETE has been done all the same,
+    // so it's too late to look first.
+    //
+    if (_database.reports_row_counts()) {
+        if (const optional<uint64_t> count = remove_where(pred, bindings))
+            return *count != 0;
+        throw malformed_results_exception();
+    }
+    if (empty_impl(pred, bindings))  return false;
+
+    remove_where(pred, bindings);
     return true;
 }
 
+string
+table_base::quoted(const binomen &b, const database &db) {
+    const unique_ptr<sql> cmd = db.make_sql();
+    cmd->write_quoted(b);
+    return cmd->get_text();
+}
+
 optional<column_id>
 table_base::readback_id() const {
     if (const serial_mapper * const readback = readback_mapper())
@@ -232,21 +319,41 @@ table_base::readback_id() const {
         return boost::none;
 }
 
+unique_ptr<sql>
+table_base::sql_delete(
+    const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings,
+    const abstract_mapper_base *returning
+) const {
+    unique_ptr<sql> cmd = _database.make_sql();
+    const optional<sql::marker_t> with_site = cmd->begin_with_clause();  // in case pred uses a cte
+    cmd->write_delete_from(_binomen);
+    if (! a_priori_true(pred))  cmd->write_where(pred);
+    if (returning != nullptr)  cmd->write_returning(*returning);
+    if (with_site)  cmd->end_with_clause(*with_site);
+    cmd->bind_parameters(bindings);
+    return cmd;
+}
+
 template<typename Src>
 unique_ptr<sql>
 table_base::sql_update(
     const abstract_mapper_base &dest,
     const Src &src,
     const abstract_predicate &pred,
+    const sql::parameter_bindings &bindings,
     const abstract_mapper_base *returning
 ) const {
     if (! is_subset(dest.columns(), _value_mapper.columns()))
         throw outside_table_exception(_binomen);
 
     unique_ptr<sql> cmd = _database.make_sql();
+    const optional<sql::marker_t> with_site = cmd->begin_with_clause();  // in case pred uses a cte
     cmd->write_update(_binomen, dest, src, readback_id());
     if (! a_priori_true(pred))  cmd->write_where(pred);
     if (returning != nullptr)  cmd->write_returning(*returning);
+    if (with_site)  cmd->end_with_clause(*with_site);
+    cmd->bind_parameters(bindings);
     return cmd;
 }
 
@@ -256,6 +363,7 @@ table_base::sql_update<abstract_mapper_base>(
     const abstract_mapper_base &,
     const abstract_mapper_base &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base *
 ) const;
 template
@@ -264,6 +372,7 @@ table_base::sql_update<row>(
     const abstract_mapper_base &,
     const row &,
     const abstract_predicate &,
+    const sql::parameter_bindings &,
     const abstract_mapper_base *
 ) const ;
 
@@ -327,7 +436,7 @@ table_base::add_field_impl(const abstract_mapper_base &dest, const Src &src) con
     _database.get_session()->exec(*cmd);
 
     if (! readback || dest.column_ids() != column_id_set{*readback})
-        update_with_no_output(dest, src, predicate(true));
+        update_with_no_output(dest, src, predicate(true), sql::parameter_bindings());
 
     cmd = _database.make_sql();
     cmd->write_constrain_as_not_null_where_appropriate(_binomen, dest);
@@ -21,7 +21,8 @@ table_alias_base::~table_alias_base()
 void
 table_alias_base::write_table_reference(sql &cmd) const {
     _table.write_table_reference(cmd);
-    cmd.write(" AS " + _name);
+    cmd.write(" AS ");
+    cmd.write(_name);
 }
 
 column_id_set